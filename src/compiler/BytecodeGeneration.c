@@ -36,6 +36,7 @@ THE SOFTWARE.
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define CHECK_BC_SIZE(N) \
     if((N) > GEN_BC_SIZE) { \
@@ -46,17 +47,28 @@ THE SOFTWARE.
         Universe_error_exit(s); \
     }
 
+// remember where the last two bytecodes start, for inlining; the parser marks
+// those pushing block literals
+#define NOTE_BC_START() \
+    mgenc->previous_bytecode = mgenc->last_bytecode; \
+    mgenc->last_bytecode = mgenc->bp; \
+    mgenc->previous_is_block_literal = mgenc->last_is_block_literal; \
+    mgenc->last_is_block_literal = false
+
 #define EMIT1(BC) \
     CHECK_BC_SIZE(mgenc->bp+1); \
+    NOTE_BC_START(); \
     mgenc->bytecode[mgenc->bp++] = (BC)
 
 #define EMIT2(BC, IDX) \
     CHECK_BC_SIZE(mgenc->bp+2); \
+    NOTE_BC_START(); \
     mgenc->bytecode[mgenc->bp++] = (BC); \
     mgenc->bytecode[mgenc->bp++] = (IDX)
 
 #define EMIT3(BC, IDX, CTX) \
     CHECK_BC_SIZE(mgenc->bp+3); \
+    NOTE_BC_START(); \
     mgenc->bytecode[mgenc->bp++] = (BC); \
     mgenc->bytecode[mgenc->bp++] = (IDX); \
     mgenc->bytecode[mgenc->bp++] = (CTX)
@@ -82,8 +94,8 @@ void emit_PUSH_ARGUMENT(method_generation_context* mgenc, size_t idx, size_t ctx
 }
 
 
-void emit_PUSH_FIELD(method_generation_context* mgenc, pVMSymbol field) {
-    EMIT2(BC_PUSH_FIELD, SEND(mgenc->literals, indexOf, field));
+void emit_PUSH_FIELD(method_generation_context* mgenc, size_t idx) {
+    EMIT2(BC_PUSH_FIELD, idx);
 }
 
 
@@ -107,8 +119,8 @@ void emit_PUSH_CONSTANT_String(
 }
 
 
-void emit_PUSH_GLOBAL(method_generation_context* mgenc, pVMSymbol global) {
-    EMIT2(BC_PUSH_GLOBAL, SEND(mgenc->literals, indexOf, global));
+void emit_PUSH_GLOBAL(method_generation_context* mgenc, pVMArray binding) {
+    EMIT2(BC_PUSH_GLOBAL, SEND(mgenc->literals, indexOf, binding));
 }
 
 
@@ -127,13 +139,39 @@ void emit_POP_ARGUMENT(method_generation_context* mgenc, size_t idx, size_t ctx)
 }
 
 
-void emit_POP_FIELD(method_generation_context* mgenc, pVMSymbol field) {
-    EMIT2(BC_POP_FIELD, SEND(mgenc->literals, indexOf, field));
+void emit_POP_FIELD(method_generation_context* mgenc, size_t idx) {
+    EMIT2(BC_POP_FIELD, idx);
 }
 
 
+/*
+ * Selectors which are sent with dedicated bytecodes, so that the interpreter
+ * can handle Integer and Double operands without a lookup.
+ */
+static const struct {
+    const char* selector;
+    uint8_t     bytecode;
+} special_sends[] = {
+    { "+",  BC_SEND_PLUS },
+    { "-",  BC_SEND_MINUS },
+    { "*",  BC_SEND_STAR },
+    { "//", BC_SEND_SLASHSLASH },
+    { "<",  BC_SEND_LESS },
+    { ">",  BC_SEND_MORE },
+    { "<=", BC_SEND_LESS_EQUAL },
+    { "=",  BC_SEND_EQUAL }
+};
+
+
 void emit_SEND(method_generation_context* mgenc, pVMSymbol msg) {
-    EMIT2(BC_SEND, method_genc_find_literal_index(mgenc, (pVMObject)msg));
+    uint8_t bc = BC_SEND;
+    const char* selector = SEND(msg, get_rawChars);
+    for(size_t i = 0; i < sizeof(special_sends) / sizeof(special_sends[0]); i++)
+        if(strcmp(selector, special_sends[i].selector) == 0) {
+            bc = special_sends[i].bytecode;
+            break;
+        }
+    EMIT2(bc, method_genc_find_literal_index(mgenc, (pVMObject)msg));
 }
 
 
@@ -150,3 +188,33 @@ void emit_RETURN_LOCAL(method_generation_context* mgenc) {
 void emit_RETURN_NON_LOCAL(method_generation_context* mgenc) {
     EMIT1(BC_RETURN_NON_LOCAL);
 }
+
+
+size_t emit_JUMP(method_generation_context* mgenc) {
+    EMIT3(BC_JUMP, 0, 0);
+    return mgenc->last_bytecode;
+}
+
+
+size_t emit_JUMP_IF_FALSE(method_generation_context* mgenc) {
+    EMIT3(BC_JUMP_IF_FALSE, 0, 0);
+    return mgenc->last_bytecode;
+}
+
+
+size_t emit_JUMP_IF_TRUE(method_generation_context* mgenc) {
+    EMIT3(BC_JUMP_IF_TRUE, 0, 0);
+    return mgenc->last_bytecode;
+}
+
+
+size_t emit_JUMP_IF_NOT_INTEGER(method_generation_context* mgenc) {
+    EMIT3(BC_JUMP_IF_NOT_INTEGER, 0, 0);
+    return mgenc->last_bytecode;
+}
+
+
+void emit_JUMP_BACKWARD(method_generation_context* mgenc, size_t target) {
+    size_t offset = mgenc->bp - target;
+    EMIT3(BC_JUMP_BACKWARD, offset & 0xff, offset >> 8);
+}
@@ -41,19 +41,27 @@ void emit_HALT(method_generation_context* mgenc);
 void emit_DUP(method_generation_context* mgenc);
 void emit_PUSH_LOCAL(method_generation_context* mgenc, size_t idx, size_t ctx);
 void emit_PUSH_ARGUMENT(method_generation_context* mgenc, size_t idx, size_t ctx);
-void emit_PUSH_FIELD(method_generation_context* mgenc, pVMSymbol field);
+void emit_PUSH_FIELD(method_generation_context* mgenc, size_t idx);
 void emit_PUSH_BLOCK(method_generation_context* mgenc, pVMMethod block);
 void emit_PUSH_CONSTANT(method_generation_context* mgenc, pVMObject cst);
 void emit_PUSH_CONSTANT_String(method_generation_context* mgenc, pVMString str);
-void emit_PUSH_GLOBAL(method_generation_context* mgenc, pVMSymbol global);
+void emit_PUSH_GLOBAL(method_generation_context* mgenc, pVMArray binding);
 void emit_POP(method_generation_context* mgenc);
 void emit_POP_LOCAL(method_generation_context* mgenc, size_t idx, size_t ctx);
 void emit_POP_ARGUMENT(method_generation_context* mgenc, size_t idx, size_t ctx);
-void emit_POP_FIELD(method_generation_context* mgenc, pVMSymbol field);
+void emit_POP_FIELD(method_generation_context* mgenc, size_t idx);
 void emit_SEND(method_generation_context* mgenc, pVMSymbol msg);
 void emit_SUPER_SEND(method_generation_context* mgenc, pVMSymbol msg);
 void emit_RETURN_LOCAL(method_generation_context* mgenc);
 void emit_RETURN_NON_LOCAL(method_generation_context* mgenc);
 
+// forward jumps are emitted with an offset of 0 and return their position,
+// for method_genc_patch_jump()
+size_t emit_JUMP(method_generation_context* mgenc);
+size_t emit_JUMP_IF_FALSE(method_generation_context* mgenc);
+size_t emit_JUMP_IF_TRUE(method_generation_context* mgenc);
+size_t emit_JUMP_IF_NOT_INTEGER(method_generation_context* mgenc);
+void emit_JUMP_BACKWARD(method_generation_context* mgenc, size_t target);
+
 
 #endif // BYTECODEGENERATION_H_
@@ -113,6 +113,28 @@ void Disassembler_dump(pVMClass class) {
 #define BC_2 SEND(method, get_bytecode,bc_idx+2)
 
 
+/**
+ * Return the name of the field with the given index in the method's holder.
+ */
+static const char* field_name_of(pVMMethod method, uint8_t index) {
+    pVMClass holder = TSEND(VMInvokable, method, get_holder);
+    if(holder == NULL || (pVMObject)holder == nil_object)
+        return "?";
+    pVMSymbol name = SEND(holder, get_instance_field_name, index);
+    return SEND(name, get_rawChars);
+}
+
+
+/**
+ * Return the bytecode index the jump at the given index jumps to.
+ */
+static int jump_target_of(pVMMethod method, size_t bc_idx) {
+    uint8_t jump[] = { BC_0, BC_1, BC_2 };
+    int offset = BC_JUMP_OFFSET(jump);
+    return (int)bc_idx + (jump[0] == BC_JUMP_BACKWARD ? -offset : offset);
+}
+
+
 /**
  * Dump all Bytecode of a method.
  */
@@ -144,12 +166,10 @@ void Disassembler_dump_method(pVMMethod method, const char* indent) {
                 debug_print("local: %d, context: %d\n", BC_1, BC_2); break;
             case BC_PUSH_ARGUMENT:
                 debug_print("argument: %d, context %d\n", BC_1, BC_2); break;
-            case BC_PUSH_FIELD:{
-                pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
+            case BC_PUSH_FIELD:
                 debug_print("(index: %d) field: %s\n", BC_1,
-                    SEND(name, get_rawChars));
+                    field_name_of(method, BC_1));
                 break;
-            }
             case BC_PUSH_BLOCK: {
                 char nindent[strlen(indent)+1+1];
                 debug_print("block: (index: %d) ", BC_1);
@@ -168,7 +188,9 @@ void Disassembler_dump_method(pVMMethod method, const char* indent) {
                 break;
             }
             case BC_PUSH_GLOBAL: {
-                pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
+                pVMArray binding =
+                    (pVMArray)SEND(method, get_constant, bc_idx);
+                pVMSymbol name = (pVMSymbol)GLOBAL_BINDING_NAME(binding);
                 debug_print("(index: %d) value: %s\n", BC_1,
                             SEND(name, get_rawChars));
                 break;
@@ -179,13 +201,19 @@ void Disassembler_dump_method(pVMMethod method, const char* indent) {
             case BC_POP_ARGUMENT:
                 debug_print("argument: %d, context: %d\n", BC_1, BC_2);
                 break;
-            case BC_POP_FIELD: {
-                pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
+            case BC_POP_FIELD:
                 debug_print("(index: %d) field: %s\n", BC_1,
-                    SEND(name, get_rawChars));
+                    field_name_of(method, BC_1));
                 break;
-            }
-            case BC_SEND: {
+            case BC_SEND:
+            case BC_SEND_PLUS:
+            case BC_SEND_MINUS:
+            case BC_SEND_STAR:
+            case BC_SEND_SLASHSLASH:
+            case BC_SEND_LESS:
+            case BC_SEND_MORE:
+            case BC_SEND_LESS_EQUAL:
+            case BC_SEND_EQUAL: {
                 pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
                 debug_print("(index: %d) signature: %s\n", BC_1,
                     SEND(name, get_rawChars));
@@ -197,6 +225,13 @@ void Disassembler_dump_method(pVMMethod method, const char* indent) {
                     SEND(name, get_rawChars));
                 break;
             }
+            case BC_JUMP:
+            case BC_JUMP_IF_FALSE:
+            case BC_JUMP_IF_TRUE:
+            case BC_JUMP_BACKWARD:
+            case BC_JUMP_IF_NOT_INTEGER:
+                debug_print("target: %d\n", jump_target_of(method, bc_idx));
+                break;
             default:
                 debug_print("<incorrect bytecode>\n");
         }
@@ -280,9 +315,8 @@ void Disassembler_dump_bytecode(pVMFrame frame, pVMMethod method, size_t bc_idx)
         case BC_PUSH_FIELD: {
             pVMFrame ctxt = SEND(frame, get_outer_context);
             pVMObject arg = SEND(ctxt, get_argument, 0, 0);
-            pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
-            int64_t field_index = SEND((pVMObject)arg, get_field_index, name);
-           
+            uint8_t field_index = BC_1;
+            pVMSymbol name = SEND(arg, get_field_name, field_index);
             pVMObject o = SEND(arg, get_field, field_index);
             pVMClass c = SEND(o, get_class);
             pVMSymbol cname = SEND(c, get_name);
@@ -311,8 +345,9 @@ void Disassembler_dump_bytecode(pVMFrame frame, pVMMethod method, size_t bc_idx)
             break;
         }
         case BC_PUSH_GLOBAL: {
-            pVMSymbol   name = (pVMSymbol)SEND(method, get_constant, bc_idx);
-            pVMObject   o = Universe_get_global(name);
+            pVMArray    binding = (pVMArray)SEND(method, get_constant, bc_idx);
+            pVMSymbol   name = (pVMSymbol)GLOBAL_BINDING_NAME(binding);
+            pVMObject   o = GLOBAL_BINDING_VALUE(binding);
             pVMSymbol   cname;
             const char* c_cname;
             if(o) {
@@ -366,18 +401,25 @@ void Disassembler_dump_bytecode(pVMFrame frame, pVMMethod method, size_t bc_idx)
         case BC_POP_FIELD: {
             size_t sp = frame->stack_pointer;
             pVMObject o = SEND((pVMArray)frame, get_indexable_field, sp);
-            pVMSymbol name = (pVMSymbol)SEND(method, get_constant, bc_idx);
             pVMClass c = SEND(o, get_class);
             pVMSymbol cname = SEND(c, get_name);
             debug_print("(index: %d) field: %s <(%s) ",  BC_1,
-                        SEND(name, get_rawChars),
+                        field_name_of(method, BC_1),
                         SEND(cname, get_rawChars));
             _Disassembler_dispatch(o);
             debug_print(">\n");                        
             break;
         }
         case BC_SUPER_SEND:
-        case BC_SEND: {
+        case BC_SEND:
+        case BC_SEND_PLUS:
+        case BC_SEND_MINUS:
+        case BC_SEND_STAR:
+        case BC_SEND_SLASHSLASH:
+        case BC_SEND_LESS:
+        case BC_SEND_MORE:
+        case BC_SEND_LESS_EQUAL:
+        case BC_SEND_EQUAL: {
             pVMSymbol sel = (pVMSymbol)SEND(method, get_constant, bc_idx);
 
             debug_print("(index: %d) signature: %s (", BC_1,
@@ -402,6 +444,19 @@ void Disassembler_dump_bytecode(pVMFrame frame, pVMMethod method, size_t bc_idx)
             indentc--; ikind='<'; //visual
             break;
         }
+        case BC_JUMP:
+        case BC_JUMP_BACKWARD:
+            debug_print("target: %d\n", jump_target_of(method, bc_idx));
+            break;
+        case BC_JUMP_IF_FALSE:
+        case BC_JUMP_IF_TRUE:
+        case BC_JUMP_IF_NOT_INTEGER: {
+            pVMObject o = SEND(frame, get_stack_element, 0);
+            debug_print("target: %d <", jump_target_of(method, bc_idx));
+            _Disassembler_dispatch(o);
+            debug_print(">\n");
+            break;
+        }
         default:
             debug_print("<incorrect bytecode>\n");
             break;
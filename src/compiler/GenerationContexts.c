@@ -25,11 +25,15 @@ THE SOFTWARE.
  */
 
 #include "GenerationContexts.h"
+#include "BytecodeGeneration.h"
 
 #include <misc/debug.h>
+#include <misc/String.h>
 
 #include <vmobjects/Signature.h>
 #include <vmobjects/VMArray.h>
+#include <vmobjects/VMInvokable.h>
+#include <vmobjects/VMMethod.h>
 #include <vmobjects/VMSymbol.h>
 
 #include <interpreter/bytecodes.h>
@@ -87,6 +91,8 @@ void method_genc_init(method_generation_context* mgenc) {
     mgenc->block_method = false;
     mgenc->finished = false;
     mgenc->bp = 0;
+    mgenc->last_bytecode = mgenc->previous_bytecode = GEN_BC_SIZE;
+    mgenc->last_is_block_literal = mgenc->previous_is_block_literal = false;
     memset(mgenc->bytecode, 0, GEN_BC_SIZE);
     mgenc->arguments = List_new();
     mgenc->locals = List_new();
@@ -140,20 +146,41 @@ bool method_genc_find_var(
 
 
 bool method_genc_find_field(method_generation_context* mgenc,
-    pString field
+    pString field,
+    size_t* index
 ) {
+    // The field lists start with the fields inherited from the super classes,
+    // so the position in the list is the index of the field in the object.
+    // Searching backwards makes fields shadow equally named inherited ones.
     pList fields = mgenc->holder_genc->class_side ?
         mgenc->holder_genc->class_fields :
         mgenc->holder_genc->instance_fields;
-    return SEND(fields, indexOf, Universe_symbol_for_str(field)) != -1;
+    pVMSymbol field_name = Universe_symbol_for_str(field);
+    for(size_t i = SEND(fields, size); i > 0; i--) {
+        if(SEND(fields, get, i - 1) == field_name) {
+            *index = i - 1;
+            return true;
+        }
+    }
+    return false;
 }
 
 
 uint8_t method_genc_compute_stack_depth(method_generation_context* mgenc) {
     uint8_t depth = 0;
     uint8_t max_depth = 0;
+    // the stack depth at the targets of forward jumps, -1 if there is none
+    int16_t depth_at[GEN_BC_SIZE + 1];
+    memset(depth_at, -1, sizeof(depth_at));
+    // whether the previous bytecode does not continue with the next one
+    bool diverted = false;
     int i = 0;
     while(i < mgenc->bp) {
+        // code following a jump or return is reached by jumps only (if at all)
+        if(diverted && depth_at[i] != -1)
+            depth = depth_at[i];
+        diverted = false;
+        
         switch(mgenc->bytecode[i]) {
             case BC_HALT             :          i++;    break;
             case BC_DUP              : depth++; i++;    break;
@@ -168,7 +195,15 @@ uint8_t method_genc_compute_stack_depth(method_generation_context* mgenc) {
             case BC_POP_ARGUMENT     : depth--; i += 3; break;
             case BC_POP_FIELD        : depth--; i += 2; break;
             case BC_SEND             :
-            case BC_SUPER_SEND       : {
+            case BC_SUPER_SEND       :
+            case BC_SEND_PLUS        :
+            case BC_SEND_MINUS       :
+            case BC_SEND_STAR        :
+            case BC_SEND_SLASHSLASH  :
+            case BC_SEND_LESS        :
+            case BC_SEND_MORE        :
+            case BC_SEND_LESS_EQUAL  :
+            case BC_SEND_EQUAL       : {
                 // these are special: they need to look at the number of
                 // arguments (extractable from the signature)
                 pVMSymbol sig =
@@ -179,7 +214,24 @@ uint8_t method_genc_compute_stack_depth(method_generation_context* mgenc) {
                 break;
             }
             case BC_RETURN_LOCAL     :
-            case BC_RETURN_NON_LOCAL :          i++;    break;
+            case BC_RETURN_NON_LOCAL : diverted = true; i++; break;
+            case BC_JUMP_IF_FALSE    :
+            case BC_JUMP_IF_TRUE     :
+                // the jump following is taken with the condition, if that is
+                // no Boolean, and skipped otherwise
+                depth_at[i + BC_JUMP_OFFSET(&mgenc->bytecode[i])] = depth - 1;
+                depth_at[i + 3 + BC_JUMP_OFFSET(&mgenc->bytecode[i + 3])] =
+                    depth;
+                depth--; // the condition
+                i += 6;
+                break;
+            case BC_JUMP             :
+            case BC_JUMP_IF_NOT_INTEGER:
+                depth_at[i + BC_JUMP_OFFSET(&mgenc->bytecode[i])] = depth;
+                diverted = mgenc->bytecode[i] == BC_JUMP;
+                i += 3;
+                break;
+            case BC_JUMP_BACKWARD    : diverted = true; i += 3; break;
             default                  :
                 debug_error("Illegal bytecode %d.\n", mgenc->bytecode[i]);
                 Universe_exit(1);
@@ -192,6 +244,356 @@ uint8_t method_genc_compute_stack_depth(method_generation_context* mgenc) {
     return max_depth;
 }
 
+
+pVMMethod method_genc_last_block(method_generation_context* mgenc, size_t n) {
+    // Return the block pushed by the last (n = 0) or the second to last (n = 1)
+    // bytecode, provided all bytecodes from there on push block literals of
+    // the source. Block pushes ending an inlined control structure do not
+    // count. As bytecodes may have been removed again, their positions are
+    // checked against bp.
+    uint32_t starts[] = { mgenc->last_bytecode, mgenc->previous_bytecode };
+    bool literals[] = { mgenc->last_is_block_literal,
+                        mgenc->previous_is_block_literal };
+    uint32_t end = mgenc->bp;
+    for(size_t k = 0; k <= n; k++) {
+        if(!literals[k] || starts[k] + 2 != end ||
+           mgenc->bytecode[starts[k]] != BC_PUSH_BLOCK)
+            return NULL;
+        end = starts[k];
+    }
+    return (pVMMethod)SEND(mgenc->literals, get, mgenc->bytecode[end + 1]);
+}
+
+
+void method_genc_remove_last_block(method_generation_context* mgenc) {
+    // remove the block push found by method_genc_last_block(mgenc, 0)
+    mgenc->bp = mgenc->last_bytecode;
+    mgenc->last_bytecode = mgenc->previous_bytecode;
+    mgenc->previous_bytecode = GEN_BC_SIZE;
+    mgenc->last_is_block_literal = mgenc->previous_is_block_literal;
+    mgenc->previous_is_block_literal = false;
+}
+
+
+static void set_jump_offset(method_generation_context* mgenc,
+    size_t jump,
+    size_t offset
+) {
+    mgenc->bytecode[jump + 1] = offset & 0xff;
+    mgenc->bytecode[jump + 2] = offset >> 8;
+}
+
+
+void method_genc_patch_jump(method_generation_context* mgenc, size_t jump) {
+    // let the forward jump at the given position jump to the next bytecode
+    set_jump_offset(mgenc, jump, mgenc->bp - jump);
+}
+
+
+size_t method_genc_add_unnamed_local(method_generation_context* mgenc) {
+    // a local for the compiler's own use, which no variable name refers to
+    SEND(mgenc->locals, add, String_new("", 0));
+    return SEND(mgenc->locals, size) - 1;
+}
+
+
+static bool refers_to_context(pVMMethod block, uint8_t level) {
+    // whether the block accesses variables of the context level levels out
+    size_t length = SEND(block, get_number_of_bytecodes);
+    uint8_t bc;
+    for(size_t i = 0; i < length; i += bytecodes_get_bytecode_length(bc)) {
+        bc = SEND(block, get_bytecode, i);
+        switch(bc) {
+            case BC_PUSH_LOCAL:
+            case BC_POP_LOCAL:
+            case BC_PUSH_ARGUMENT:
+            case BC_POP_ARGUMENT:
+                if(SEND(block, get_bytecode, i + 2) == level)
+                    return true;
+                break;
+            case BC_PUSH_BLOCK:
+                if(refers_to_context(
+                        (pVMMethod)SEND(block, get_constant, i), level + 1))
+                    return true;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+
+bool method_genc_block_variables_captured(pVMMethod block) {
+    // Whether blocks nested in the given block access its arguments or
+    // locals. When it is inlined, these become variables of the outer
+    // context, which all activations of the inlined code share.
+    // The blocks pushed where an inlined control message is sent after all,
+    // from the jump following a conditional jump up to the next JUMP, are
+    // left out: they are only created for receivers that are no Booleans.
+    size_t length = SEND(block, get_number_of_bytecodes);
+    bool send_starts[GEN_BC_SIZE + 1];
+    memset(send_starts, 0, sizeof(send_starts));
+    bool sending = false;
+    uint8_t bc;
+    for(size_t i = 0; i < length; i += bytecodes_get_bytecode_length(bc)) {
+        bc = SEND(block, get_bytecode, i);
+        if(send_starts[i])
+            sending = true;
+        if(bc == BC_JUMP_IF_FALSE || bc == BC_JUMP_IF_TRUE)
+            send_starts[i + 3 + (SEND(block, get_bytecode, i + 4) |
+                                 SEND(block, get_bytecode, i + 5) << 8)] = true;
+        else if(bc == BC_JUMP)
+            sending = false;
+        else if(bc == BC_PUSH_BLOCK && !sending &&
+                refers_to_context((pVMMethod)SEND(block, get_constant, i), 1))
+            return true;
+    }
+    return false;
+}
+
+
+size_t method_genc_count_nested_blocks(pVMMethod block, size_t limit) {
+    // The number of blocks pushed by the given block and, recursively, by
+    // these, which are copied when it is inlined; counting stops at limit.
+    size_t length = SEND(block, get_number_of_bytecodes);
+    size_t count = 0;
+    uint8_t bc;
+    for(size_t i = 0; i < length && count < limit;
+        i += bytecodes_get_bytecode_length(bc))
+        if((bc = SEND(block, get_bytecode, i)) == BC_PUSH_BLOCK)
+            count += 1 + method_genc_count_nested_blocks(
+                (pVMMethod)SEND(block, get_constant, i), limit - count - 1);
+    return count < limit ? count : limit;
+}
+
+
+static pVMMethod copy_block(pVMMethod block) {
+    size_t number_of_constants =
+        SEND(block, get_number_of_indexable_fields);
+    size_t length = SEND(block, get_number_of_bytecodes);
+    pVMMethod copy = Universe_new_method(
+        TSEND(VMInvokable, block, get_signature), length,
+        number_of_constants, SEND(block, get_number_of_locals),
+        SEND(block, get_maximum_number_of_stack_elements));
+    for(size_t i = 0; i < number_of_constants; i++) {
+        pVMObject constant = SEND(block, get_indexable_field, i);
+        SEND(copy, set_indexable_field, i, constant);
+    }
+    for(size_t i = 0; i < length; i++) {
+        uint8_t bc = SEND(block, get_bytecode, i);
+        SEND(copy, set_bytecode, i, bc);
+    }
+    return copy;
+}
+
+
+static pVMMethod adapt_nested_block(pVMMethod block,
+    uint8_t level,
+    size_t first_local,
+    size_t number_of_arguments
+) {
+    // The given block is nested level contexts deep in a block that is inlined
+    // into its outer context. Variables of the inlined block become locals of
+    // the outer context (see method_genc_inline_block), which is also where
+    // the contexts further out are now found one level closer. The block is
+    // left as it is, since it is still used where inlining is given up on at
+    // run time; an adapted copy is returned.
+    pVMMethod copy = copy_block(block);
+    size_t length = SEND(copy, get_number_of_bytecodes);
+    uint8_t bc;
+    for(size_t i = 0; i < length; i += bytecodes_get_bytecode_length(bc)) {
+        bc = SEND(copy, get_bytecode, i);
+        switch(bc) {
+            case BC_PUSH_LOCAL:
+            case BC_POP_LOCAL:
+            case BC_PUSH_ARGUMENT:
+            case BC_POP_ARGUMENT: {
+                uint8_t index = SEND(copy, get_bytecode, i + 1);
+                uint8_t context = SEND(copy, get_bytecode, i + 2);
+                if(context > level)
+                    SEND(copy, set_bytecode, i + 2, context - 1);
+                else if(context == level) {
+                    bool push = bc == BC_PUSH_LOCAL || bc == BC_PUSH_ARGUMENT;
+                    if(bc == BC_PUSH_LOCAL || bc == BC_POP_LOCAL)
+                        index += first_local + number_of_arguments;
+                    else
+                        index += first_local - 1;
+                    SEND(copy, set_bytecode, i,
+                         push ? BC_PUSH_LOCAL : BC_POP_LOCAL);
+                    SEND(copy, set_bytecode, i + 1, index);
+                }
+                break;
+            }
+            case BC_PUSH_BLOCK: {
+                pVMMethod nested = adapt_nested_block(
+                    (pVMMethod)SEND(copy, get_constant, i), level + 1,
+                    first_local, number_of_arguments);
+                uint8_t index = SEND(copy, get_bytecode, i + 1);
+                SEND(copy, set_indexable_field, index, (pVMObject)nested);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return copy;
+}
+
+
+void method_genc_inline_block(method_generation_context* mgenc,
+    pVMMethod block
+) {
+    // Emit the bytecodes of the given block in place, leaving the value of its
+    // last expression on the stack instead of returning it. The arguments of
+    // the block (except for the block itself) are expected on the stack. They
+    // and the locals of the block, in this order, become unnamed locals of
+    // mgenc.
+    size_t number_of_arguments = SEND(block, get_number_of_arguments) - 1;
+    size_t number_of_locals = SEND(block, get_number_of_locals);
+    size_t first_local = SEND(mgenc->locals, size);
+    for(size_t i = 0; i < number_of_arguments + number_of_locals; i++)
+        method_genc_add_unnamed_local(mgenc);
+    
+    for(size_t i = number_of_arguments; i > 0; i--)
+        emit_POP_LOCAL(mgenc, first_local + i - 1, 0);
+    
+    // the locals of a block are nil whenever it starts
+    if(number_of_locals > 0) {
+        pVMArray nil_binding =
+            Universe_get_global_binding(Universe_symbol_for_cstr("nil"));
+        SEND(mgenc->literals, addIfAbsent, nil_binding);
+        for(size_t i = 0; i < number_of_locals; i++) {
+            emit_PUSH_GLOBAL(mgenc, nil_binding);
+            emit_POP_LOCAL(mgenc, first_local + number_of_arguments + i, 0);
+        }
+    }
+    
+    size_t length = SEND(block, get_number_of_bytecodes);
+    uint8_t bc;
+    for(size_t i = 0; i < length; i += bytecodes_get_bytecode_length(bc)) {
+        bc = SEND(block, get_bytecode, i);
+        switch(bc) {
+            case BC_HALT:
+                emit_HALT(mgenc);
+                break;
+            case BC_DUP:
+                emit_DUP(mgenc);
+                break;
+            case BC_POP:
+                emit_POP(mgenc);
+                break;
+            case BC_PUSH_LOCAL:
+            case BC_POP_LOCAL:
+            case BC_PUSH_ARGUMENT:
+            case BC_POP_ARGUMENT: {
+                bool push = bc == BC_PUSH_LOCAL || bc == BC_PUSH_ARGUMENT;
+                bool local = bc == BC_PUSH_LOCAL || bc == BC_POP_LOCAL;
+                size_t index = SEND(block, get_bytecode, i + 1);
+                size_t context = SEND(block, get_bytecode, i + 2);
+                if(context == 0) {
+                    // a variable of the block itself
+                    index += local ?
+                        first_local + number_of_arguments : first_local - 1;
+                    local = true;
+                } else
+                    context--;
+                if(push && local)
+                    emit_PUSH_LOCAL(mgenc, index, context);
+                else if(push)
+                    emit_PUSH_ARGUMENT(mgenc, index, context);
+                else if(local)
+                    emit_POP_LOCAL(mgenc, index, context);
+                else
+                    emit_POP_ARGUMENT(mgenc, index, context);
+                break;
+            }
+            case BC_PUSH_FIELD:
+                emit_PUSH_FIELD(mgenc, SEND(block, get_bytecode, i + 1));
+                break;
+            case BC_POP_FIELD:
+                emit_POP_FIELD(mgenc, SEND(block, get_bytecode, i + 1));
+                break;
+            case BC_PUSH_BLOCK: {
+                pVMMethod nested = adapt_nested_block(
+                    (pVMMethod)SEND(block, get_constant, i), 1, first_local,
+                    number_of_arguments);
+                SEND(mgenc->literals, add, nested);
+                emit_PUSH_BLOCK(mgenc, nested);
+                break;
+            }
+            case BC_PUSH_CONSTANT: {
+                pVMObject constant = SEND(block, get_constant, i);
+                SEND(mgenc->literals, addIfAbsent, constant);
+                emit_PUSH_CONSTANT(mgenc, constant);
+                break;
+            }
+            case BC_PUSH_GLOBAL: {
+                pVMArray binding = (pVMArray)SEND(block, get_constant, i);
+                SEND(mgenc->literals, addIfAbsent, binding);
+                emit_PUSH_GLOBAL(mgenc, binding);
+                break;
+            }
+            case BC_SEND:
+            case BC_SEND_PLUS:
+            case BC_SEND_MINUS:
+            case BC_SEND_STAR:
+            case BC_SEND_SLASHSLASH:
+            case BC_SEND_LESS:
+            case BC_SEND_MORE:
+            case BC_SEND_LESS_EQUAL:
+            case BC_SEND_EQUAL:
+            case BC_SUPER_SEND: {
+                pVMSymbol signature = (pVMSymbol)SEND(block, get_constant, i);
+                SEND(mgenc->literals, addIfAbsent, signature);
+                if(bc == BC_SUPER_SEND)
+                    emit_SUPER_SEND(mgenc, signature);
+                else
+                    emit_SEND(mgenc, signature);
+                break;
+            }
+            case BC_RETURN_LOCAL:
+                // the implicit return at the end of the block: its value
+                // becomes the value of the inlined code
+                break;
+            case BC_RETURN_NON_LOCAL:
+                // returning from a method's own context is a local return
+                if(mgenc->block_method)
+                    emit_RETURN_NON_LOCAL(mgenc);
+                else
+                    emit_RETURN_LOCAL(mgenc);
+                break;
+            case BC_JUMP:
+            case BC_JUMP_IF_FALSE:
+            case BC_JUMP_IF_TRUE:
+            case BC_JUMP_IF_NOT_INTEGER: {
+                // the bytecodes keep their lengths, hence jumps their offsets
+                size_t jump;
+                switch(bc) {
+                    case BC_JUMP:          jump = emit_JUMP(mgenc);          break;
+                    case BC_JUMP_IF_FALSE: jump = emit_JUMP_IF_FALSE(mgenc); break;
+                    case BC_JUMP_IF_TRUE:  jump = emit_JUMP_IF_TRUE(mgenc);  break;
+                    default: jump = emit_JUMP_IF_NOT_INTEGER(mgenc);         break;
+                }
+                set_jump_offset(mgenc, jump,
+                    SEND(block, get_bytecode, i + 1) |
+                    SEND(block, get_bytecode, i + 2) << 8);
+                break;
+            }
+            case BC_JUMP_BACKWARD: {
+                size_t offset = SEND(block, get_bytecode, i + 1) |
+                    SEND(block, get_bytecode, i + 2) << 8;
+                emit_JUMP_BACKWARD(mgenc, mgenc->bp - offset);
+                break;
+            }
+            default:
+                debug_error("Illegal bytecode %d.\n", bc);
+                Universe_exit(1);
+        }
+    }
+}
+
+
 bool method_genc_has_bytecodes(method_generation_context* mgenc) {
     return mgenc->bp != 0;
 }
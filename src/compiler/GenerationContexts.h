@@ -46,7 +46,7 @@ typedef struct _class_generation_context {
 } class_generation_context;
 
 
-#define GEN_BC_SIZE 1024
+#define GEN_BC_SIZE 4096
 
 // declare forward
 struct _method_generation_context;
@@ -63,6 +63,10 @@ struct _method_generation_context {
     pList                      literals;
     bool                       finished;
     uint32_t                   bp;
+    uint32_t                   last_bytecode;
+    uint32_t                   previous_bytecode;
+    bool                       last_is_block_literal;
+    bool                       previous_is_block_literal;
     uint8_t                    bytecode[GEN_BC_SIZE];
 };
 
@@ -85,9 +89,24 @@ bool    method_genc_find_var(
     size_t* context,
     bool* is_argument
 );
-bool    method_genc_find_field(method_generation_context* mgenc, pString field);
+bool    method_genc_find_field(
+    method_generation_context* mgenc,
+    pString field,
+    size_t* index
+);
 uint8_t method_genc_compute_stack_depth(method_generation_context* mgenc);
 
+pVMMethod method_genc_last_block(method_generation_context* mgenc, size_t n);
+void    method_genc_remove_last_block(method_generation_context* mgenc);
+size_t  method_genc_add_unnamed_local(method_generation_context* mgenc);
+bool    method_genc_block_variables_captured(pVMMethod block);
+size_t  method_genc_count_nested_blocks(pVMMethod block, size_t limit);
+void    method_genc_inline_block(
+    method_generation_context* mgenc,
+    pVMMethod block
+);
+void    method_genc_patch_jump(method_generation_context* mgenc, size_t jump);
+
 bool    method_genc_has_bytecodes(method_generation_context* mgenc);
 
 #endif // GENERATIONCONTEXTS_H_
@@ -37,6 +37,8 @@ THE SOFTWARE.
 
 #include <misc/defs.h>
 
+#include <interpreter/bytecodes.h>
+
 #include <memory/gc.h>
 
 #include <vmobjects/VMClass.h>
@@ -336,6 +338,17 @@ bool expectOneOf(Lexer* l, Symbol* ss) {
 #pragma mark helper functions for pushing / popping variables
 
 
+static void gen_push_global(method_generation_context* mgenc,
+    pVMSymbol global
+) {
+    // Globals are referenced through their binding cells, which are kept up to
+    // date by the Universe; the cell of a yet unknown global is created here.
+    pVMArray binding = Universe_get_global_binding(global);
+    SEND(mgenc->literals, addIfAbsent, binding);
+    emit_PUSH_GLOBAL(mgenc, binding);
+}
+
+
 void gen_push_variable(method_generation_context* mgenc, pString var) {
     // The purpose of this function is to find out whether the variable to be
     // pushed on the stack is a local variable, argument, or object field. This
@@ -350,15 +363,10 @@ void gen_push_variable(method_generation_context* mgenc, pString var) {
             emit_PUSH_ARGUMENT(mgenc, index, context);
         else
             emit_PUSH_LOCAL(mgenc, index, context);
-    else if(method_genc_find_field(mgenc, var)) {
-        pVMSymbol fieldName = Universe_symbol_for_str(var);
-        SEND(mgenc->literals, addIfAbsent, fieldName);
-        emit_PUSH_FIELD(mgenc, fieldName);
-    } else {
-        pVMSymbol global = Universe_symbol_for_str(var);
-        SEND(mgenc->literals, addIfAbsent, global);
-        emit_PUSH_GLOBAL(mgenc, global);
-    }
+    else if(method_genc_find_field(mgenc, var, &index))
+        emit_PUSH_FIELD(mgenc, index);
+    else
+        gen_push_global(mgenc, Universe_symbol_for_str(var));
 }
 
 
@@ -377,12 +385,355 @@ void gen_pop_variable(method_generation_context* mgenc, pString var) {
         } else {
             emit_POP_LOCAL(mgenc, index, context);
         }
+    } else if(method_genc_find_field(mgenc, var, &index)) {
+        emit_POP_FIELD(mgenc, index);
     } else {
-        emit_POP_FIELD(mgenc, Universe_symbol_for_str(var));
+        fprintf(stderr, "Error: cannot assign to undefined variable %s\n",
+                SEND(var, rawChars));
+        Universe_exit(ERR_FAIL);
     }
 }
 
 
+#pragma mark helper functions for inlining control structures
+
+
+// Inlining copies the blocks nested in the inlined one, and those pushed for
+// sending the message after all keep their own nested blocks, so the copies
+// double with each level of inlined control structures. Blocks with more
+// nested blocks than this are not inlined.
+#define MAX_INLINED_NESTED_BLOCKS 64
+
+
+static bool inlinable_block(pVMMethod block,
+    int64_t number_of_arguments,
+    bool loop
+) {
+    // Only literal blocks with the expected number of arguments are inlined.
+    // The variables of an inlined loop block are shared by all iterations, so
+    // if nested blocks capture them, the loop block has to keep its own
+    // contexts.
+    if(block == NULL ||
+       SEND(block, get_number_of_arguments) != number_of_arguments + 1 ||
+       method_genc_count_nested_blocks(block, MAX_INLINED_NESTED_BLOCKS + 1) >
+           MAX_INLINED_NESTED_BLOCKS)
+        return false;
+    return !loop || !method_genc_block_variables_captured(block);
+}
+
+
+static void gen_send(method_generation_context* mgenc, const char* selector) {
+    pVMSymbol msg = Universe_symbol_for_cstr(selector);
+    SEND(mgenc->literals, addIfAbsent, msg);
+    emit_SEND(mgenc, msg);
+}
+
+
+static size_t gen_conditional_jump(method_generation_context* mgenc,
+    bool on_true,
+    size_t* to_send
+) {
+    // A conditional jump is followed by a jump that is taken if the condition
+    // is no Boolean, which is left on the stack for the control message to be
+    // sent to it after all. The code sending it has to end with a JUMP (see
+    // method_genc_block_variables_captured). The positions of both jumps are
+    // returned for patching.
+    size_t jump = on_true ? emit_JUMP_IF_TRUE(mgenc) : emit_JUMP_IF_FALSE(mgenc);
+    *to_send = emit_JUMP(mgenc);
+    return jump;
+}
+
+
+static void gen_send_fallback(method_generation_context* mgenc,
+    pVMMethod block,
+    pVMMethod other_block,
+    pVMSymbol msg
+) {
+    // where the receiver is not what the inlined code expects, the blocks are
+    // created after all, and the message sent (its other arguments are pushed
+    // by the caller)
+    emit_PUSH_BLOCK(mgenc, block);
+    if(other_block)
+        emit_PUSH_BLOCK(mgenc, other_block);
+    SEND(mgenc->literals, addIfAbsent, msg);
+    emit_SEND(mgenc, msg);
+}
+
+
+static bool gen_inlined_if(method_generation_context* mgenc,
+    pVMSymbol msg,
+    bool if_true,
+    bool has_else
+) {
+    // <condition> JUMP_IF_FALSE else JUMP send <then> JUMP end
+    // send: PUSH_BLOCK <then> [PUSH_BLOCK <else>] SEND <msg> JUMP end
+    // else: <else> end:
+    // (with nil instead of the missing else block, and jumping on true for
+    // ifFalse:)
+    pVMMethod then_block = method_genc_last_block(mgenc, has_else ? 1 : 0);
+    pVMMethod else_block = has_else ? method_genc_last_block(mgenc, 0) : NULL;
+    if(!inlinable_block(then_block, 0, false) ||
+       (has_else && !inlinable_block(else_block, 0, false)))
+        return false;
+    method_genc_remove_last_block(mgenc);
+    if(has_else)
+        method_genc_remove_last_block(mgenc);
+    
+    size_t to_send;
+    size_t to_else = gen_conditional_jump(mgenc, !if_true, &to_send);
+    method_genc_inline_block(mgenc, then_block);
+    size_t to_end = emit_JUMP(mgenc);
+    method_genc_patch_jump(mgenc, to_send);
+    gen_send_fallback(mgenc, then_block, else_block, msg);
+    size_t sent_to_end = emit_JUMP(mgenc);
+    method_genc_patch_jump(mgenc, to_else);
+    if(has_else)
+        method_genc_inline_block(mgenc, else_block);
+    else
+        gen_push_global(mgenc, Universe_symbol_for_cstr("nil"));
+    method_genc_patch_jump(mgenc, to_end);
+    method_genc_patch_jump(mgenc, sent_to_end);
+    return true;
+}
+
+
+static bool gen_inlined_while(method_generation_context* mgenc,
+    pVMSymbol msg,
+    bool while_true
+) {
+    // loop: <condition> JUMP_IF_FALSE end JUMP send <body> POP
+    // JUMP_BACKWARD loop
+    // send: POP PUSH_BLOCK <condition> PUSH_BLOCK <body> SEND <msg> JUMP done
+    // end: PUSH_GLOBAL nil done: (jumping on true for whileFalse:)
+    // The message sent evaluates the condition once more.
+    pVMMethod condition_block = method_genc_last_block(mgenc, 1);
+    pVMMethod body_block = method_genc_last_block(mgenc, 0);
+    if(!inlinable_block(condition_block, 0, true) ||
+       !inlinable_block(body_block, 0, true))
+        return false;
+    method_genc_remove_last_block(mgenc);
+    method_genc_remove_last_block(mgenc);
+    
+    size_t loop = mgenc->bp;
+    method_genc_inline_block(mgenc, condition_block);
+    size_t to_send;
+    size_t to_end = gen_conditional_jump(mgenc, !while_true, &to_send);
+    method_genc_inline_block(mgenc, body_block);
+    emit_POP(mgenc);
+    emit_JUMP_BACKWARD(mgenc, loop);
+    method_genc_patch_jump(mgenc, to_send);
+    emit_POP(mgenc);
+    gen_send_fallback(mgenc, condition_block, body_block, msg);
+    size_t to_done = emit_JUMP(mgenc);
+    method_genc_patch_jump(mgenc, to_end);
+    gen_push_global(mgenc, Universe_symbol_for_cstr("nil"));
+    method_genc_patch_jump(mgenc, to_done);
+    return true;
+}
+
+
+static bool gen_inlined_and_or(method_generation_context* mgenc,
+    pVMSymbol msg,
+    bool is_or
+) {
+    // <receiver> JUMP_IF_FALSE short JUMP send <block> JUMP end
+    // send: PUSH_BLOCK SEND <msg> JUMP end short: PUSH_GLOBAL false end:
+    // (jumping on true and pushing true for or:)
+    pVMMethod block = method_genc_last_block(mgenc, 0);
+    if(!inlinable_block(block, 0, false))
+        return false;
+    method_genc_remove_last_block(mgenc);
+    
+    size_t to_send;
+    size_t to_short = gen_conditional_jump(mgenc, is_or, &to_send);
+    method_genc_inline_block(mgenc, block);
+    size_t to_end = emit_JUMP(mgenc);
+    method_genc_patch_jump(mgenc, to_send);
+    gen_send_fallback(mgenc, block, NULL, msg);
+    size_t sent_to_end = emit_JUMP(mgenc);
+    method_genc_patch_jump(mgenc, to_short);
+    gen_push_global(mgenc, Universe_symbol_for_cstr(is_or ? "true" : "false"));
+    method_genc_patch_jump(mgenc, to_end);
+    method_genc_patch_jump(mgenc, sent_to_end);
+    return true;
+}
+
+
+static size_t gen_counted_loop(method_generation_context* mgenc,
+    pVMMethod block,
+    size_t counter,
+    size_t limit,
+    pVMObject step_constant,
+    size_t step,
+    bool down,
+    size_t* to_resend
+) {
+    // The loop of Integer>>#to:do: and its variants, with the block inlined:
+    // loop: PUSH_LOCAL counter PUSH_LOCAL limit SEND <= JUMP_IF_FALSE end
+    // JUMP resend [PUSH_LOCAL counter] <block> POP PUSH_LOCAL counter <step>
+    // SEND + POP_LOCAL counter JUMP_BACKWARD loop
+    // The step is pushed from step_constant or, if that is NULL, from the
+    // local step. Counting down uses >= and - instead. The positions of the
+    // jump to the end and of the jump taken if the comparison yields no
+    // Boolean are returned for patching.
+    size_t loop = mgenc->bp;
+    emit_PUSH_LOCAL(mgenc, counter, 0);
+    emit_PUSH_LOCAL(mgenc, limit, 0);
+    gen_send(mgenc, down ? ">=" : "<=");
+    size_t to_end = gen_conditional_jump(mgenc, false, to_resend);
+    
+    if(SEND(block, get_number_of_arguments) > 1)
+        emit_PUSH_LOCAL(mgenc, counter, 0);
+    method_genc_inline_block(mgenc, block);
+    emit_POP(mgenc);
+    
+    emit_PUSH_LOCAL(mgenc, counter, 0);
+    if(step_constant) {
+        SEND(mgenc->literals, addIfAbsent, step_constant);
+        emit_PUSH_CONSTANT(mgenc, step_constant);
+    } else
+        emit_PUSH_LOCAL(mgenc, step, 0);
+    gen_send(mgenc, down ? "-" : "+");
+    emit_POP_LOCAL(mgenc, counter, 0);
+    emit_JUMP_BACKWARD(mgenc, loop);
+    return to_end;
+}
+
+
+static bool gen_inlined_to_do(method_generation_context* mgenc,
+    pVMSymbol msg,
+    bool by,
+    bool down
+) {
+    // <receiver> <limit> [<step>] [POP_LOCAL step] POP_LOCAL limit
+    // JUMP_IF_NOT_INTEGER send DUP POP_LOCAL counter <counted loop>
+    // resend: POP PUSH_LOCAL counter PUSH_LOCAL limit [PUSH_LOCAL step]
+    // PUSH_BLOCK SEND <msg> POP JUMP end
+    // send: PUSH_LOCAL limit [PUSH_LOCAL step] PUSH_BLOCK SEND <msg> end:
+    // The receiver remains on the stack as the value of the loop.
+    pVMMethod block = method_genc_last_block(mgenc, 0);
+    if(!inlinable_block(block, 1, true))
+        return false;
+    method_genc_remove_last_block(mgenc);
+    
+    size_t limit = method_genc_add_unnamed_local(mgenc);
+    size_t counter = method_genc_add_unnamed_local(mgenc);
+    size_t step = by ? method_genc_add_unnamed_local(mgenc) : 0;
+    if(by)
+        emit_POP_LOCAL(mgenc, step, 0);
+    emit_POP_LOCAL(mgenc, limit, 0);
+    size_t to_send = emit_JUMP_IF_NOT_INTEGER(mgenc);
+    emit_DUP(mgenc);
+    emit_POP_LOCAL(mgenc, counter, 0);
+    size_t to_resend;
+    size_t to_end = gen_counted_loop(mgenc, block, counter, limit,
+        by ? NULL : (pVMObject)Universe_new_integer(1), step, down,
+        &to_resend);
+    
+    // the remaining iterations are left to the message
+    method_genc_patch_jump(mgenc, to_resend);
+    emit_POP(mgenc);
+    emit_PUSH_LOCAL(mgenc, counter, 0);
+    emit_PUSH_LOCAL(mgenc, limit, 0);
+    if(by)
+        emit_PUSH_LOCAL(mgenc, step, 0);
+    gen_send_fallback(mgenc, block, NULL, msg);
+    emit_POP(mgenc);
+    size_t resent_to_end = emit_JUMP(mgenc);
+    
+    method_genc_patch_jump(mgenc, to_send);
+    emit_PUSH_LOCAL(mgenc, limit, 0);
+    if(by)
+        emit_PUSH_LOCAL(mgenc, step, 0);
+    gen_send_fallback(mgenc, block, NULL, msg);
+    method_genc_patch_jump(mgenc, to_end);
+    method_genc_patch_jump(mgenc, resent_to_end);
+    return true;
+}
+
+
+static bool gen_inlined_times_repeat(method_generation_context* mgenc,
+    pVMSymbol msg
+) {
+    // <receiver> JUMP_IF_NOT_INTEGER send DUP POP_LOCAL limit
+    // PUSH_CONSTANT 1 POP_LOCAL counter <counted loop>
+    // resend: POP PUSH_LOCAL limit PUSH_LOCAL counter SEND - PUSH_CONSTANT 1
+    // SEND + PUSH_BLOCK SEND timesRepeat: POP JUMP end
+    // send: PUSH_BLOCK SEND timesRepeat: end:
+    pVMMethod block = method_genc_last_block(mgenc, 0);
+    if(!inlinable_block(block, 0, true))
+        return false;
+    method_genc_remove_last_block(mgenc);
+    
+    size_t limit = method_genc_add_unnamed_local(mgenc);
+    size_t counter = method_genc_add_unnamed_local(mgenc);
+    pVMObject one = (pVMObject)Universe_new_integer(1);
+    size_t to_send = emit_JUMP_IF_NOT_INTEGER(mgenc);
+    emit_DUP(mgenc);
+    emit_POP_LOCAL(mgenc, limit, 0);
+    SEND(mgenc->literals, addIfAbsent, one);
+    emit_PUSH_CONSTANT(mgenc, one);
+    emit_POP_LOCAL(mgenc, counter, 0);
+    size_t to_resend;
+    size_t to_end = gen_counted_loop(mgenc, block, counter, limit, one, 0,
+        false, &to_resend);
+    
+    // the remaining iterations are left to the message
+    method_genc_patch_jump(mgenc, to_resend);
+    emit_POP(mgenc);
+    emit_PUSH_LOCAL(mgenc, limit, 0);
+    emit_PUSH_LOCAL(mgenc, counter, 0);
+    gen_send(mgenc, "-");
+    emit_PUSH_CONSTANT(mgenc, one);
+    gen_send(mgenc, "+");
+    gen_send_fallback(mgenc, block, NULL, msg);
+    emit_POP(mgenc);
+    size_t resent_to_end = emit_JUMP(mgenc);
+    
+    method_genc_patch_jump(mgenc, to_send);
+    gen_send_fallback(mgenc, block, NULL, msg);
+    method_genc_patch_jump(mgenc, to_end);
+    method_genc_patch_jump(mgenc, resent_to_end);
+    return true;
+}
+
+
+static bool gen_inlined_message(method_generation_context* mgenc,
+    pVMSymbol msg
+) {
+    // Control structures with literal blocks as their arguments (and as their
+    // receiver, for the conditional loops) are compiled to jumps rather than
+    // sends, which remain for receivers of other classes; all other cases are
+    // left to the sends.
+    const char* selector = SEND(msg, get_rawChars);
+    if(strcmp(selector, "ifTrue:") == 0)
+        return gen_inlined_if(mgenc, msg, true, false);
+    if(strcmp(selector, "ifFalse:") == 0)
+        return gen_inlined_if(mgenc, msg, false, false);
+    if(strcmp(selector, "ifTrue:ifFalse:") == 0)
+        return gen_inlined_if(mgenc, msg, true, true);
+    if(strcmp(selector, "ifFalse:ifTrue:") == 0)
+        return gen_inlined_if(mgenc, msg, false, true);
+    if(strcmp(selector, "whileTrue:") == 0)
+        return gen_inlined_while(mgenc, msg, true);
+    if(strcmp(selector, "whileFalse:") == 0)
+        return gen_inlined_while(mgenc, msg, false);
+    if(strcmp(selector, "and:") == 0)
+        return gen_inlined_and_or(mgenc, msg, false);
+    if(strcmp(selector, "or:") == 0)
+        return gen_inlined_and_or(mgenc, msg, true);
+    if(strcmp(selector, "to:do:") == 0)
+        return gen_inlined_to_do(mgenc, msg, false, false);
+    if(strcmp(selector, "to:by:do:") == 0)
+        return gen_inlined_to_do(mgenc, msg, true, false);
+    if(strcmp(selector, "downTo:do:") == 0)
+        return gen_inlined_to_do(mgenc, msg, false, true);
+    if(strcmp(selector, "timesRepeat:") == 0)
+        return gen_inlined_times_repeat(mgenc, msg);
+    return false;
+}
+
+
 //
 // grammar
 //
@@ -504,13 +855,14 @@ void superclass(Lexer* l, class_generation_context* cgenc) {
         // However, that makes it static, it is going to make it harder to
         // change the definition of Class and Object
 
-        // There are exactly 4 fields
-        Universe_assert(4 == SIZE_DIFF_VMOBJECT(VMClass));
+        // There are exactly 5 fields
+        Universe_assert(5 == SIZE_DIFF_VMOBJECT(VMClass));
 
         const char* field_names[] = {
-            "superClass", "name", "instanceFields", "instanceInvokables"};
+            "superClass", "name", "instanceFields", "instanceInvokables",
+            "invokablesTable"};
 
-        pVMArray class_fields = Universe_new_array_from_argv(4, field_names);
+        pVMArray class_fields = Universe_new_array_from_argv(5, field_names);
         class_genc_set_class_fields_of_super(cgenc, class_fields);
     }
 }
@@ -705,9 +1057,7 @@ void blockBody(Lexer* l, method_generation_context* mgenc, bool seen_period) {
             mgenc->bp--;
         }
         if (mgenc->block_method && !method_genc_has_bytecodes(mgenc)) {
-            pVMSymbol nilSym = Universe_symbol_for_cstr("nil");
-            SEND(mgenc->literals, addIfAbsent, nilSym);
-            emit_PUSH_GLOBAL(mgenc, nilSym);
+            gen_push_global(mgenc, Universe_symbol_for_cstr("nil"));
         }
         emit_RETURN_LOCAL(mgenc);
         mgenc->finished = true;
@@ -828,6 +1178,7 @@ bool primary(Lexer* l, method_generation_context* mgenc) {
             pVMMethod block_method = VMMethod_assemble(&bgenc);
             SEND(mgenc->literals, add, block_method);
             emit_PUSH_BLOCK(mgenc, block_method);
+            mgenc->last_is_block_literal = true;
             
             method_genc_release(&bgenc);
             break;
@@ -926,6 +1277,8 @@ void keywordMessage(Lexer* l, method_generation_context* mgenc, bool super) {
     
     pVMSymbol msg = Universe_symbol_for_str(kw);
     SEND(kw, free);
+    if(!super && gen_inlined_message(mgenc, msg))
+        return;
     SEND(mgenc->literals, addIfAbsent, msg);
     
     if(super)
@@ -1126,9 +1479,7 @@ void nestedBlock(Lexer* l, method_generation_context* mgenc) {
     // in the block was not terminated by ., and can generate a return
     if (!mgenc->finished) {
         if (!method_genc_has_bytecodes(mgenc)) {
-            pVMSymbol nilSym = Universe_symbol_for_cstr("nil");
-            SEND(mgenc->literals, addIfAbsent, nilSym);
-            emit_PUSH_GLOBAL(mgenc, nilSym);
+            gen_push_global(mgenc, Universe_symbol_for_cstr("nil"));
         }
         emit_RETURN_LOCAL(mgenc);
         mgenc->finished = true;
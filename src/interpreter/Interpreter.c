@@ -33,25 +33,82 @@ THE SOFTWARE.
 
 #include <vmobjects/Signature.h>
 #include <vmobjects/VMInvokable.h>
+#include <vmobjects/VMInteger.h>
+#include <vmobjects/VMDouble.h>
 
 #include <compiler/Disassembler.h>
 
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// Threaded dispatch (computed goto on labels as values) is a GNU C extension
+// understood by gcc and clang. Other compilers, or builds defining
+// SWITCH_DISPATCH, use the portable switch-based loop.
+#if defined(__GNUC__) && !defined(SWITCH_DISPATCH)
+    #define THREADED_DISPATCH
+#endif
 
 
 // class variable.
 static pVMFrame frame;
 
+// Incremented whenever a class' methods change. Inline caches filled in an
+// earlier epoch are discarded when their method next sends a message.
+static uintptr_t inline_cache_epoch = 1;
+
+// Whether the special selector sends (BC_SEND_PLUS to BC_SEND_EQUAL) may handle
+// Integer (index 0) and Double (index 1) operands inline. That is the case
+// as long as these classes define the selectors themselves. The states are
+// determined lazily and discarded along with the inline caches.
+#define NUMBER_OF_SPECIAL_SENDS (BC_SEND_EQUAL - BC_SEND_PLUS + 1)
+
+enum { SPECIAL_SEND_UNKNOWN = 0, SPECIAL_SEND_INLINE, SPECIAL_SEND_SEND };
+
+static uint8_t   special_send_states[2][NUMBER_OF_SPECIAL_SENDS];
+static uintptr_t special_send_epoch;
+
+// send statistics
+static uint64_t inline_cache_hits;
+static uint64_t inline_cache_misses;
+static uint64_t megamorphic_sends;
+
 // convenience macros for frequently used function invocations
 #define _FRAME Interpreter_get_frame()
 #define _SETFRAME(f) Interpreter_set_frame(f)
 #define _METHOD Interpreter_get_method()
 #define _SELF Interpreter_get_self()
 
+// direct access to the frame and method layouts (see VMFrame.h and
+// VMMethod.h) for the interpreter's inlined bytecode handlers
+#define FRAME_STACK(f) \
+    (&(f)->fields[SIZE_DIFF_VMOBJECT(VMFrame)])
+#define METHOD_CONSTANTS(m) \
+    (&(m)->fields[SIZE_DIFF_VMOBJECT(VMMethod)])
+#define METHOD_BYTECODES(m) \
+    ((uint8_t*)&(m)->fields[(m)->num_of_fields])
+
 #pragma mark private bytecode handlers.
 
+static inline pVMFrame context_at_level(pVMFrame context, uint8_t level) {
+    // Follow the context chain for the given number of levels
+    while(level-- > 0)
+        context = context->context;
+    return context;
+}
+
+
+static inline pVMObject self_of(pVMFrame context) {
+    // self is the receiver argument of the outermost context
+    while((pVMObject)context->context != nil_object)
+        context = context->context;
+    return FRAME_STACK(context)[0];
+}
+
+
 static pVMFrame pop_frame(void) {
     // Save a reference to the top frame
     pVMFrame result = _FRAME;
@@ -83,10 +140,101 @@ static void pop_frame_and_push_result(pVMObject result) {
 }
 
 
-static void send(pVMSymbol signature, pVMClass receiver_class) {
-    // Lookup the invokable with the given signature
+static inline_cache* get_inline_cache(pVMMethod method,
+                                      size_t bytecode_index) {
+    // (Re)initialize the method's inline caches if there are none yet, or if
+    // they were filled before the last change to some class' methods
+    if(method->inline_cache_epoch != inline_cache_epoch) {
+        if(method->inline_caches)
+            VMMethod_reset_inline_caches(method);
+        else {
+            method->inline_caches = (inline_cache*)internal_allocate(
+                sizeof(inline_cache) * method->bytecodes_length);
+            gc_register_external_storage(method);
+        }
+        method->inline_cache_epoch = inline_cache_epoch;
+    }
+    return &method->inline_caches[bytecode_index];
+}
+
+
+static inline bool special_send_inlinable(pVMClass receiver_class,
+                                          uint8_t bytecode,
+                                          pVMSymbol signature) {
+    if(special_send_epoch != inline_cache_epoch) {
+        memset(special_send_states, 0, sizeof(special_send_states));
+        special_send_epoch = inline_cache_epoch;
+    }
+    uint8_t* state = &special_send_states[receiver_class == double_class]
+                                         [bytecode - BC_SEND_PLUS];
+    if(*state == SPECIAL_SEND_UNKNOWN) {
+        pVMObject invokable =
+            SEND(receiver_class, lookup_invokable, signature);
+        *state = invokable &&
+                 TSEND(VMInvokable, invokable, get_holder) == receiver_class ?
+            SPECIAL_SEND_INLINE : SPECIAL_SEND_SEND;
+    }
+    return *state == SPECIAL_SEND_INLINE;
+}
+
+
+static pVMObject cached_lookup(pVMSymbol signature, pVMClass receiver_class,
+                               inline_cache* cache) {
+    // monomorphic hit
+    if(cache->receiver_class == receiver_class) {
+        inline_cache_hits++;
+        return cache->invokable;
+    }
+
+    polymorphic_cache* pic = cache->polymorphic;
+    if(pic) {
+        if(pic->megamorphic) {
+            // rely on the global lookup cache
+            megamorphic_sends++;
+            return (pVMObject)SEND(receiver_class, lookup_invokable, signature);
+        }
+        // polymorphic hit
+        for(size_t i = 0; i < pic->size; i++)
+            if(pic->receiver_classes[i] == receiver_class) {
+                inline_cache_hits++;
+                return pic->invokables[i];
+            }
+    }
+
+    // miss: do the full lookup and remember the result at the send site
+    inline_cache_misses++;
     pVMObject invokable = (pVMObject)SEND(receiver_class,
                                           lookup_invokable, signature);
+    if(invokable == NULL)
+        return NULL;
+
+    if(cache->receiver_class == NULL) {
+        cache->receiver_class = receiver_class;
+        cache->invokable = invokable;
+    } else if(pic == NULL) {
+        pic = (polymorphic_cache*)internal_allocate(sizeof(polymorphic_cache));
+        pic->receiver_classes[0] = receiver_class;
+        pic->invokables[0] = invokable;
+        pic->size = 1;
+        cache->polymorphic = pic;
+    } else if(pic->size < POLYMORPHIC_CACHE_SIZE) {
+        pic->receiver_classes[pic->size] = receiver_class;
+        pic->invokables[pic->size] = invokable;
+        pic->size++;
+    } else {
+        // too many receiver classes, give up on caching at this site
+        pic->megamorphic = true;
+        pic->size = 0;
+    }
+    return invokable;
+}
+
+
+static void send(pVMSymbol signature, pVMClass receiver_class,
+                 inline_cache* cache) {
+    // Lookup the invokable with the given signature, consulting the send
+    // site's inline cache first
+    pVMObject invokable = cached_lookup(signature, receiver_class, cache);
 
     if(invokable != NULL)
         // Invoke the invokable in the current frame
@@ -123,53 +271,6 @@ static void send(pVMSymbol signature, pVMClass receiver_class) {
 
 #pragma mark  Bytecode handling functions
 
-static void do_dup(void) {
-    // Handle the dup bytecode
-    pVMObject elem = SEND(_FRAME, get_stack_element, 0);
-    SEND(_FRAME, push, elem);
-}
-
-
-static void do_push_local(size_t bytecode_index) {
-    // Handle the push local bytecode
-    pVMMethod method = _METHOD;
-    uint8_t bc1 = SEND(method, get_bytecode, bytecode_index + 1);
-    uint8_t bc2 = SEND(method, get_bytecode, bytecode_index + 2);
-    
-    pVMObject local = SEND(_FRAME, get_local, bc1, bc2);
-    
-    SEND(_FRAME, push, local);
-}
-
-
-static void do_push_argument(size_t bytecode_index) {
-    // Handle the push argument bytecode
-    pVMMethod method = _METHOD;
-    uint8_t bc1 = SEND(method, get_bytecode, bytecode_index + 1);
-    uint8_t bc2 = SEND(method, get_bytecode, bytecode_index + 2);
-    
-    pVMObject argument = SEND(_FRAME, get_argument, bc1, bc2);
-    
-    SEND(_FRAME, push, argument);
-}
-
-
-static void do_push_field(size_t bytecode_index) {
-    pVMMethod method = _METHOD;
-    // Handle the push field bytecode
-    pVMSymbol field_name =
-        (pVMSymbol)SEND(method, get_constant, bytecode_index);
-    
-    // Get the field index from the field name
-    pVMObject self = _SELF;
-    int64_t field_index = SEND(self, get_field_index, field_name);
-    
-    pVMObject o = SEND(self, get_field, field_index);
-    // Push the field with the computed index onto the stack
-    SEND(_FRAME, push, o);
-}
-
-
 static void do_push_block(size_t bytecode_index) {
     pVMMethod method = _METHOD;
     // Handle the push block bytecode
@@ -185,23 +286,14 @@ static void do_push_block(size_t bytecode_index) {
 }
 
 
-static void do_push_constant(size_t bytecode_index) {
-    pVMMethod method = _METHOD;
-    
-    // Handle the push constant bytecode
-    pVMObject constant = SEND(method, get_constant, bytecode_index);
-    SEND(_FRAME, push, constant);
-}
-
-
 static void do_push_global(size_t bytecode_index) {
     pVMMethod method = _METHOD;
     // Handle the push global bytecode
-    pVMSymbol global_name = (pVMSymbol)SEND(method,
-                                            get_constant, bytecode_index);
+    pVMArray binding = (pVMArray)SEND(method, get_constant, bytecode_index);
+    pVMSymbol global_name = (pVMSymbol)GLOBAL_BINDING_NAME(binding);
         
-    // Get the global from the Universe
-    pVMObject global = Universe_get_global(global_name);
+    // Get the global from its binding cell
+    pVMObject global = GLOBAL_BINDING_VALUE(binding);
         
     if(global != NULL)
         // Push the global onto the stack
@@ -215,52 +307,9 @@ static void do_push_global(size_t bytecode_index) {
 }
 
 
-static void do_pop(void) {
-    // Handle the pop bytecode
-    SEND(_FRAME, pop);
-}
-
-
-static void do_pop_local(size_t bytecode_index) {
-    pVMMethod method = _METHOD;
-    // Handle the pop local bytecode
-    uint8_t bc1 = SEND(method, get_bytecode, bytecode_index + 1);
-    uint8_t bc2 = SEND(method, get_bytecode, bytecode_index + 2);
-   
-    pVMObject o =  SEND(_FRAME, pop);
-    
-    SEND(_FRAME, set_local, bc1, bc2, o);
-}
-
-
-static void do_pop_argument(size_t bytecode_index) {
-    pVMMethod method = _METHOD;
-    // Handle the pop argument bytecode
-    uint8_t bc1 = SEND(method, get_bytecode, bytecode_index + 1);
-    uint8_t bc2 = SEND(method, get_bytecode, bytecode_index + 2);
-
-    pVMObject o =  SEND(_FRAME, pop);
-    SEND(_FRAME, set_argument, bc1, bc2, o);
-}
-
-
-static void do_pop_field(size_t bytecode_index) {
-    pVMMethod method = _METHOD;
-    // Handle the pop field bytecode
-    pVMSymbol field_name = (pVMSymbol)SEND(method, 
-                                           get_constant, bytecode_index);
-                
-    // Get the field index from the field name
-    pVMObject self = _SELF;
-    int64_t field_index = SEND(self, get_field_index, field_name);
-    
-    // Set the field with the computed index to the value popped from the stack
-    pVMObject o = SEND(_FRAME, pop);
-    SEND(self, set_field, field_index, o);
-}
-
-
 static void do_send(size_t bytecode_index) {
+    // sends are safepoints: the interpreter state is stored in the frames
+    gc_safepoint();
     pVMMethod method = _METHOD;
     // Handle the send bytecode
     pVMSymbol signature = (pVMSymbol)SEND(method, 
@@ -274,11 +323,13 @@ static void do_send(size_t bytecode_index) {
         SEND(_FRAME, get_stack_element, number_of_arguments - 1);
 
     // Send the message
-    send(signature, SEND(receiver, get_class));
+    send(signature, SEND(receiver, get_class),
+         get_inline_cache(method, bytecode_index));
 }
 
 
 static void do_super_send(size_t bytecode_index) {
+    gc_safepoint();
     pVMMethod method = _METHOD;
     // Handle the super send bytecode
     pVMSymbol signature = (pVMSymbol)SEND(method, 
@@ -390,47 +441,370 @@ void Interpreter_initialize(pVMObject nilObject) {
 }
 
 void Interpreter_start(void) {
+    // The interpreter state of the current frame lives in these locals. It is
+    // written back to the frame (SPILL) before anything that may look at the
+    // frame from the outside - sends, returns, primitives and allocations,
+    // i.e., potential GC points - and is re-read (RELOAD) afterwards, since
+    // any of these may have switched to another frame.
+    pVMFrame   fp;        // the current frame
+    pVMMethod  method;    // the method executing in fp
+    uint8_t*   bytecodes; // the bytecodes of method
+    uint8_t*   ip;        // the current bytecode
+    pVMObject* stack;     // the first indexable slot of fp
+    pVMObject* sp;        // the top of the stack
+    size_t     bytecode_index;
+
+    #define SPILL() \
+        fp->bytecode_index = ip - bytecodes; \
+        fp->stack_pointer = sp - stack
+
+    #define RELOAD() \
+        fp = frame; \
+        gc_remember_if_old(fp); \
+        method = fp->method; \
+        bytecodes = METHOD_BYTECODES(method); \
+        ip = bytecodes + fp->bytecode_index; \
+        stack = FRAME_STACK(fp); \
+        sp = stack + fp->stack_pointer
+
+#ifdef THREADED_DISPATCH
+    // one label per bytecode, indexed by the bytecode constants; all other
+    // byte values lead to the error the switch reports by default
+    static void* dispatch_table[256] = {
+        [0 ... 255]           = &&LABEL_UNEXPECTED,
+        [BC_HALT]             = &&LABEL_BC_HALT,
+        [BC_DUP]              = &&LABEL_BC_DUP,
+        [BC_PUSH_LOCAL]       = &&LABEL_BC_PUSH_LOCAL,
+        [BC_PUSH_ARGUMENT]    = &&LABEL_BC_PUSH_ARGUMENT,
+        [BC_PUSH_FIELD]       = &&LABEL_BC_PUSH_FIELD,
+        [BC_PUSH_BLOCK]       = &&LABEL_BC_PUSH_BLOCK,
+        [BC_PUSH_CONSTANT]    = &&LABEL_BC_PUSH_CONSTANT,
+        [BC_PUSH_GLOBAL]      = &&LABEL_BC_PUSH_GLOBAL,
+        [BC_POP]              = &&LABEL_BC_POP,
+        [BC_POP_LOCAL]        = &&LABEL_BC_POP_LOCAL,
+        [BC_POP_ARGUMENT]     = &&LABEL_BC_POP_ARGUMENT,
+        [BC_POP_FIELD]        = &&LABEL_BC_POP_FIELD,
+        [BC_SEND]             = &&LABEL_BC_SEND,
+        [BC_SUPER_SEND]       = &&LABEL_BC_SUPER_SEND,
+        [BC_RETURN_LOCAL]     = &&LABEL_BC_RETURN_LOCAL,
+        [BC_RETURN_NON_LOCAL] = &&LABEL_BC_RETURN_NON_LOCAL,
+        [BC_SEND_PLUS]        = &&LABEL_BC_SEND_PLUS,
+        [BC_SEND_MINUS]       = &&LABEL_BC_SEND_MINUS,
+        [BC_SEND_STAR]        = &&LABEL_BC_SEND_STAR,
+        [BC_SEND_SLASHSLASH]  = &&LABEL_BC_SEND_SLASHSLASH,
+        [BC_SEND_LESS]        = &&LABEL_BC_SEND_LESS,
+        [BC_SEND_MORE]        = &&LABEL_BC_SEND_MORE,
+        [BC_SEND_LESS_EQUAL]  = &&LABEL_BC_SEND_LESS_EQUAL,
+        [BC_SEND_EQUAL]       = &&LABEL_BC_SEND_EQUAL,
+        [BC_JUMP]             = &&LABEL_BC_JUMP,
+        [BC_JUMP_IF_FALSE]    = &&LABEL_BC_JUMP_IF_FALSE,
+        [BC_JUMP_IF_TRUE]     = &&LABEL_BC_JUMP_IF_TRUE,
+        [BC_JUMP_BACKWARD]    = &&LABEL_BC_JUMP_BACKWARD,
+        [BC_JUMP_IF_NOT_INTEGER] = &&LABEL_BC_JUMP_IF_NOT_INTEGER
+    };
+
+    // Every handler ends in its own copy of the fetch sequence and an indirect
+    // jump to the next handler, so that the branch predictor gets one slot
+    // per bytecode instead of a single shared switch jump.
+    #define DISPATCH \
+        FETCH_NEXT_BYTECODE(); \
+        goto *dispatch_table[*ip]
+
+    #define CASE(bc) LABEL_##bc:
+    #define NEXT     DISPATCH
+#else
+    #define CASE(bc) case bc:
+    #define NEXT     break
+#endif
+
+    // Trace the bytecode at ip, if wanted (means dump_bytecodes is at least 2)
+    #define FETCH_NEXT_BYTECODE() \
+        if(dump_bytecodes > 1) { \
+            SPILL(); \
+            Disassembler_dump_bytecode(fp, method, ip - bytecodes); \
+        }
+
+    // Leave the current bytecode of length len: out-of-line handlers expect
+    // the frame's bytecode index to point to the next bytecode already
+    #define ADVANCE(len) \
+        bytecode_index = ip - bytecodes; \
+        ip += (len)
+
+    // Special selector sends with a SmallInteger or Double receiver and an
+    // argument of the same kind compute the result inline, in the same way
+    // as the corresponding primitive; all other cases, including boxed
+    // Integers, are sent normally. The operands stay on the stack while a
+    // result is allocated.
+    #define SMALL_INTEGER_OPERANDS() \
+        (IS_SMALL_INTEGER(sp[-1]) && IS_SMALL_INTEGER(sp[0]))
+
+    #define IS_DOUBLE(O) \
+        (IS_SMALL_FLOAT(O) || (!IS_IMMEDIATE(O) && (O)->class == double_class))
+
+    #define DOUBLE_VALUE(O) \
+        (IS_SMALL_FLOAT(O) ? small_float_value(O) \
+                           : ((pVMDouble)(O))->embedded_double)
+
+    #define DOUBLE_OPERANDS() \
+        (IS_DOUBLE(sp[-1]) && IS_DOUBLE(sp[0]))
+
+    #define SPECIAL_SEND_OPERANDS_INLINABLE(bc) \
+        ((SMALL_INTEGER_OPERANDS() || DOUBLE_OPERANDS()) && \
+         special_send_inlinable( \
+             IS_SMALL_INTEGER(sp[-1]) ? integer_class : double_class, (bc), \
+             (pVMSymbol)METHOD_CONSTANTS(method)[ip[1]]))
+
+    #define ARITHMETIC_SEND(bc, integer_result, double_result) \
+        { \
+            if(SPECIAL_SEND_OPERANDS_INLINABLE(bc)) { \
+                pVMObject result; \
+                ADVANCE(2); \
+                SPILL(); \
+                if(IS_SMALL_INTEGER(sp[-1])) { \
+                    int64_t l = SMALL_INTEGER_VALUE(sp[-1]); \
+                    int64_t r = SMALL_INTEGER_VALUE(sp[0]); \
+                    result = (pVMObject)(integer_result); \
+                } else { \
+                    double l = DOUBLE_VALUE(sp[-1]); \
+                    double r = DOUBLE_VALUE(sp[0]); \
+                    result = (pVMObject)(double_result); \
+                } \
+                RELOAD(); \
+                *--sp = result; \
+            } else { \
+                ADVANCE(2); \
+                SPILL(); \
+                do_send(bytecode_index); \
+                RELOAD(); \
+            } \
+        }
+
+    #define COMPARISON_SEND(bc, condition) \
+        { \
+            if(SPECIAL_SEND_OPERANDS_INLINABLE(bc)) { \
+                bool holds; \
+                if(IS_SMALL_INTEGER(sp[-1])) { \
+                    int64_t l = SMALL_INTEGER_VALUE(sp[-1]); \
+                    int64_t r = SMALL_INTEGER_VALUE(sp[0]); \
+                    holds = (condition); \
+                } else { \
+                    double l = DOUBLE_VALUE(sp[-1]); \
+                    double r = DOUBLE_VALUE(sp[0]); \
+                    holds = (condition); \
+                } \
+                *--sp = holds ? true_object : false_object; \
+                ADVANCE(2); \
+            } else { \
+                ADVANCE(2); \
+                SPILL(); \
+                do_send(bytecode_index); \
+                RELOAD(); \
+            } \
+        }
+
+    // Conditional jumps pop a Boolean condition and skip the jump following
+    // them if they do not jump; any other condition stays on the stack for
+    // that jump, to the send of the inlined message.
+    #define CONDITIONAL_JUMP(jump_condition, other_condition) \
+        { \
+            if(*sp == (jump_condition)) { \
+                sp--; \
+                ip += BC_JUMP_OFFSET(ip); \
+            } else if(*sp == (other_condition)) { \
+                sp--; \
+                ip += 6; \
+            } else \
+                ip += 3; \
+        }
+
+    RELOAD();
+#ifdef THREADED_DISPATCH
+    DISPATCH;
+    {
+#else
     // iterate over the bytecodes
     while(true) {
-        // get the current bytecode index
-        size_t bytecode_index = SEND(_FRAME, get_bytecode_index);
-        // get the current bytecode
-        pVMMethod method = Interpreter_get_method();
-        uint8_t bytecode = SEND(method, get_bytecode, bytecode_index);
-        // get the length of the current bytecode
-        int bytecode_length = bytecodes_get_bytecode_length(bytecode);
-        
-        // trace, if wanted (means dump_bytecodes is at least 2)
-        if(dump_bytecodes >1)
-            Disassembler_dump_bytecode(_FRAME, method, bytecode_index);
-        
-        // compute the next bytecode index
-        size_t next_bytecode_index = bytecode_index + bytecode_length;
-        // update the bytecode index of the frame
-        SEND(_FRAME, set_bytecode_index, next_bytecode_index);
-        
-        // Handle the current bytecode
-        switch(bytecode) {
-            case BC_HALT:             return; // handle the halt bytecode
-            case BC_DUP:              do_dup();  break;
-            case BC_PUSH_LOCAL:       do_push_local(bytecode_index); break;
-            case BC_PUSH_ARGUMENT:    do_push_argument(bytecode_index); break;
-            case BC_PUSH_FIELD:       do_push_field(bytecode_index); break;
-            case BC_PUSH_BLOCK:       do_push_block(bytecode_index); break;
-            case BC_PUSH_CONSTANT:    do_push_constant(bytecode_index); break;
-            case BC_PUSH_GLOBAL:      do_push_global(bytecode_index); break;
-            case BC_POP:              do_pop(); break;
-            case BC_POP_LOCAL:        do_pop_local(bytecode_index); break;
-            case BC_POP_ARGUMENT:     do_pop_argument(bytecode_index); break;
-            case BC_POP_FIELD:        do_pop_field(bytecode_index); break;
-            case BC_SEND:             do_send(bytecode_index); break;
-            case BC_SUPER_SEND:       do_super_send(bytecode_index); break;
-            case BC_RETURN_LOCAL:     do_return_local(); break;
-            case BC_RETURN_NON_LOCAL: do_return_non_local(); break;
-            default:                  Universe_error_exit(
-                                            "Interpreter: Unexpected bytecode");      
+        FETCH_NEXT_BYTECODE();
+        switch(*ip) {
+#endif
+            // Handle the current bytecode
+            CASE(BC_HALT) {
+                ADVANCE(1);
+                SPILL();
+                return;
+            }
+            CASE(BC_DUP) {
+                ADVANCE(1);
+                sp[1] = sp[0];
+                sp++;
+            } NEXT;
+            CASE(BC_PUSH_LOCAL) {
+                pVMFrame context = context_at_level(fp, ip[2]);
+                *++sp = FRAME_STACK(context)[context->local_offset + ip[1]];
+                ADVANCE(3);
+            } NEXT;
+            CASE(BC_PUSH_ARGUMENT) {
+                pVMFrame context = context_at_level(fp, ip[2]);
+                *++sp = FRAME_STACK(context)[ip[1]];
+                ADVANCE(3);
+            } NEXT;
+            CASE(BC_PUSH_FIELD) {
+                // the operand is the field index resolved by the compiler
+                *++sp = self_of(fp)->fields[ip[1]];
+                ADVANCE(2);
+            } NEXT;
+            CASE(BC_PUSH_BLOCK) {
+                ADVANCE(2);
+                SPILL();
+                do_push_block(bytecode_index);
+                RELOAD();
+            } NEXT;
+            CASE(BC_PUSH_CONSTANT) {
+                *++sp = METHOD_CONSTANTS(method)[ip[1]];
+                ADVANCE(2);
+            } NEXT;
+            CASE(BC_PUSH_GLOBAL) {
+                pVMArray binding = (pVMArray)METHOD_CONSTANTS(method)[ip[1]];
+                pVMObject global = GLOBAL_BINDING_VALUE(binding);
+                ADVANCE(2);
+                if(global != NULL)
+                    *++sp = global;
+                else {
+                    // unbound globals are handled by sending unknownGlobal:
+                    SPILL();
+                    do_push_global(bytecode_index);
+                    RELOAD();
+                }
+            } NEXT;
+            CASE(BC_POP) {
+                ADVANCE(1);
+                sp--;
+            } NEXT;
+            CASE(BC_POP_LOCAL) {
+                pVMFrame context = context_at_level(fp, ip[2]);
+                gc_write_barrier(context, *sp);
+                FRAME_STACK(context)[context->local_offset + ip[1]] = *sp--;
+                ADVANCE(3);
+            } NEXT;
+            CASE(BC_POP_ARGUMENT) {
+                pVMFrame context = context_at_level(fp, ip[2]);
+                gc_write_barrier(context, *sp);
+                FRAME_STACK(context)[ip[1]] = *sp--;
+                ADVANCE(3);
+            } NEXT;
+            CASE(BC_POP_FIELD) {
+                pVMObject self = self_of(fp);
+                gc_write_barrier(self, *sp);
+                self->fields[ip[1]] = *sp--;
+                ADVANCE(2);
+            } NEXT;
+            CASE(BC_SEND) {
+                ADVANCE(2);
+                SPILL();
+                do_send(bytecode_index);
+                RELOAD();
+            } NEXT;
+            CASE(BC_SUPER_SEND) {
+                ADVANCE(2);
+                SPILL();
+                do_super_send(bytecode_index);
+                RELOAD();
+            } NEXT;
+            CASE(BC_RETURN_LOCAL) {
+                ADVANCE(1);
+                SPILL();
+                do_return_local();
+                RELOAD();
+            } NEXT;
+            CASE(BC_RETURN_NON_LOCAL) {
+                ADVANCE(1);
+                SPILL();
+                do_return_non_local();
+                RELOAD();
+            } NEXT;
+            CASE(BC_SEND_PLUS)
+                ARITHMETIC_SEND(BC_SEND_PLUS,
+                                Universe_new_integer(l + r),
+                                Universe_new_double(l + r)) NEXT;
+            CASE(BC_SEND_MINUS)
+                ARITHMETIC_SEND(BC_SEND_MINUS,
+                                Universe_new_integer(l - r),
+                                Universe_new_double(l - r)) NEXT;
+            CASE(BC_SEND_STAR)
+                ARITHMETIC_SEND(BC_SEND_STAR,
+                                Universe_new_integer(l * r),
+                                Universe_new_double(l * r)) NEXT;
+            CASE(BC_SEND_SLASHSLASH)
+                ARITHMETIC_SEND(BC_SEND_SLASHSLASH,
+                                Universe_new_double((double)l / (double)r),
+                                Universe_new_double(l / r)) NEXT;
+            // > and <= are derived from < and = as in the Smalltalk library,
+            // which makes a difference for NaN operands
+            CASE(BC_SEND_LESS)
+                COMPARISON_SEND(BC_SEND_LESS, l < r) NEXT;
+            CASE(BC_SEND_MORE)
+                COMPARISON_SEND(BC_SEND_MORE, !(l < r || l == r)) NEXT;
+            CASE(BC_SEND_LESS_EQUAL)
+                COMPARISON_SEND(BC_SEND_LESS_EQUAL, l < r || l == r) NEXT;
+            CASE(BC_SEND_EQUAL)
+                COMPARISON_SEND(BC_SEND_EQUAL, l == r) NEXT;
+            CASE(BC_JUMP) {
+                ip += BC_JUMP_OFFSET(ip);
+            } NEXT;
+            CASE(BC_JUMP_IF_FALSE)
+                CONDITIONAL_JUMP(false_object, true_object) NEXT;
+            CASE(BC_JUMP_IF_TRUE)
+                CONDITIONAL_JUMP(true_object, false_object) NEXT;
+            CASE(BC_JUMP_BACKWARD) {
+                // loops are safepoints, so that they cannot defer a minor
+                // collection indefinitely
+                if(gc_collection_pending) {
+                    SPILL();
+                    gc_safepoint();
+                    RELOAD();
+                }
+                ip -= BC_JUMP_OFFSET(ip);
+            } NEXT;
+            CASE(BC_JUMP_IF_NOT_INTEGER) {
+                if(!IS_SMALL_INTEGER(*sp) &&
+                   (IS_IMMEDIATE(*sp) || (*sp)->class != integer_class))
+                    ip += BC_JUMP_OFFSET(ip);
+                else
+                    ip += 3;
+            } NEXT;
+#ifdef THREADED_DISPATCH
+            LABEL_UNEXPECTED:
+#else
+            default:
+#endif
+                Universe_error_exit("Interpreter: Unexpected bytecode");
+#ifndef THREADED_DISPATCH
         } // switch
+#endif
     } // while
+
+    #undef SPILL
+    #undef RELOAD
+    #undef FETCH_NEXT_BYTECODE
+    #undef ADVANCE
+    #undef DISPATCH
+    #undef CASE
+    #undef NEXT
+}
+
+
+void Interpreter_invalidate_inline_caches(void) {
+    inline_cache_epoch++;
+}
+
+
+void Interpreter_stat(void) {
+    fprintf(stderr, "-- Interpreter statistics --\n");
+    fprintf(stderr, "* inline cache hits: %llu, misses: %llu\n",
+            (unsigned long long)inline_cache_hits,
+            (unsigned long long)inline_cache_misses);
+    fprintf(stderr, "* megamorphic sends: %llu\n",
+            (unsigned long long)megamorphic_sends);
 }
 
 
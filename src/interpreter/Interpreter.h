@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 void      Interpreter_initialize(pVMObject nilObject);
 void      Interpreter_start(void);
+void      Interpreter_invalidate_inline_caches(void);
+void      Interpreter_stat(void);
 pVMFrame  Interpreter_push_new_frame(pVMMethod method, pVMFrame context);
 void      Interpreter_set_frame(pVMFrame frame);
 pVMFrame  Interpreter_get_frame(void);
@@ -48,6 +48,35 @@ THE SOFTWARE.
 #define BC_RETURN_LOCAL      14
 #define BC_RETURN_NON_LOCAL  15
 
+// sends of special selectors, with inline fast paths for Integer and Double
+// operands; their operand is the signature, as with BC_SEND
+#define BC_SEND_PLUS         16
+#define BC_SEND_MINUS        17
+#define BC_SEND_STAR         18
+#define BC_SEND_SLASHSLASH   19
+#define BC_SEND_LESS         20
+#define BC_SEND_MORE         21
+#define BC_SEND_LESS_EQUAL   22
+#define BC_SEND_EQUAL        23
+
+#define BC_IS_SPECIAL_SEND(bc) \
+    ((bc) >= BC_SEND_PLUS && (bc) <= BC_SEND_EQUAL)
+
+// jumps generated for inlined control structures; the conditional jumps pop
+// a Boolean condition and are followed by a JUMP, which is taken with any
+// other condition still on the stack
+#define BC_JUMP              24
+#define BC_JUMP_IF_FALSE     25
+#define BC_JUMP_IF_TRUE      26
+#define BC_JUMP_BACKWARD     27
+
+// jumps if the top of the stack, which stays in place, is not an Integer
+#define BC_JUMP_IF_NOT_INTEGER 28
+
+// the operand of a jump is its distance in bytes from the jump bytecode,
+// stored as 16 bit value with the least significant byte first
+#define BC_JUMP_OFFSET(bc) ((uint16_t)((bc)[1] | ((bc)[2] << 8)))
+
 // bytecode lengths
 
 //TODO: put into own module.
@@ -68,7 +97,20 @@ static const uint8_t bytecode_lengths[] = {
     2, // BC_SEND
     2, // BC_SUPER_SEND
     1, // BC_RETURN_LOCAL
-    1  // BC_RETURN_NON_LOCAL
+    1, // BC_RETURN_NON_LOCAL
+    2, // BC_SEND_PLUS
+    2, // BC_SEND_MINUS
+    2, // BC_SEND_STAR
+    2, // BC_SEND_SLASHSLASH
+    2, // BC_SEND_LESS
+    2, // BC_SEND_MORE
+    2, // BC_SEND_LESS_EQUAL
+    2, // BC_SEND_EQUAL
+    3, // BC_JUMP
+    3, // BC_JUMP_IF_FALSE
+    3, // BC_JUMP_IF_TRUE
+    3, // BC_JUMP_BACKWARD
+    3  // BC_JUMP_IF_NOT_INTEGER
 };
 
 static const char* bytecode_names[] = {
@@ -87,7 +129,20 @@ static const char* bytecode_names[] = {
     "SEND            ",
     "SUPER_SEND      ",
     "RETURN_LOCAL    ",
-    "RETURN_NON_LOCAL"
+    "RETURN_NON_LOCAL",
+    "SEND_PLUS       ",
+    "SEND_MINUS      ",
+    "SEND_STAR       ",
+    "SEND_SLASHSLASH ",
+    "SEND_LESS       ",
+    "SEND_MORE       ",
+    "SEND_LESS_EQUAL ",
+    "SEND_EQUAL      ",
+    "JUMP            ",
+    "JUMP_IF_FALSE   ",
+    "JUMP_IF_TRUE    ",
+    "JUMP_BACKWARD   ",
+    "JUMP_IF_NOT_INT "
 };
 
 static inline char* bytecodes_get_bytecode_name(uint8_t bc) {
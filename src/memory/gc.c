@@ -32,6 +32,15 @@ THE SOFTWARE.
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifndef CSOM_WIN
+#   include <sys/mman.h>
+#endif
+
+#include <pthread.h>
+#include <sched.h>
 
 
 #include <misc/Hashmap.h>
@@ -55,14 +64,66 @@ THE SOFTWARE.
 
 /*
  * free_list_entries are used to manage the space freed after the sweep phase.
- * these entries contain their own size and a reference of the entry next to them
+ * these entries contain their own size and a reference of the entry next to them.
+ * Their first word is NULL where objects have their vtable, and their size
+ * is where objects have theirs, so that the heap can be walked linearly.
  */
 struct _free_list_entry {
-    free_list_entry* next;
+    void* no_vtable;
     size_t size;
+    free_list_entry* next;
 };
 
 
+#define IS_FREE_CHUNK(P) (((free_list_entry*)(P))->no_vtable == NULL)
+
+
+/*
+ * Free chunks up to LARGEST_SIZE_CLASS bytes are kept in exact-fit lists,
+ * one per multiple of the word size. Larger ones are kept in one list.
+ */
+#define NUMBER_OF_SIZE_CLASSES 32
+#define LARGEST_SIZE_CLASS ((NUMBER_OF_SIZE_CLASSES - 1) * sizeof(void*))
+#define SIZE_CLASS(SIZE) ((SIZE) / sizeof(void*))
+
+
+/*
+ * Objects pushed onto the mark stack are prefetched, so that they are likely
+ * to be in the cache when they are popped again.
+ */
+#if defined(__GNUC__)
+    #define PREFETCH(P) __builtin_prefetch(P)
+#else
+    #define PREFETCH(P)
+#endif
+
+
+/*
+ * The marks of the objects in the object_space are kept in a bitmap besides
+ * it, with one bit for every word the object_space consists of. Only the
+ * bit of the first word of an object is used.
+ */
+#define BITS_PER_WORD (sizeof(uintptr_t) * 8)
+#define MARK_BIT_INDEX(P) \
+    (((uintptr_t)(P) - (uintptr_t)object_space) / sizeof(void*))
+
+#if defined(__GNUC__)
+    #define COUNT_TRAILING_ZEROS(X) ((size_t)__builtin_ctzl(X))
+    #define POPULATION_COUNT(X)     ((size_t)__builtin_popcountl(X))
+#else
+    static size_t COUNT_TRAILING_ZEROS(uintptr_t x) {
+        size_t n = 0;
+        for (; !(x & 1); x >>= 1) n++;
+        return n;
+    }
+    static size_t POPULATION_COUNT(uintptr_t x) {
+        size_t n = 0;
+        for (; x; x &= x - 1) n++;
+        return n;
+    }
+#endif
+
+
 /*
  * heap used by gc_allocate
  */
@@ -70,9 +131,77 @@ void* object_space = NULL;
 
 
 /*
- * the size of the heap used by gc_allocate (standard: 1 MB)
+ * the size of the heap used by gc_allocate. It starts with the initial size
+ * (standard: 1 MB) and grows and shrinks in chunks of that size, up to the
+ * maximum size (standard: 64 MB). Twice the maximum size is reserved up
+ * front, so that the object_space stays contiguous, and an allocation that
+ * does not fit anywhere else can still be served beyond the maximum until
+ * the heap is compacted.
+ */
+intptr_t OBJECT_SPACE_SIZE = 0;
+intptr_t INITIAL_OBJECT_SPACE_SIZE = 1048576;
+intptr_t MAX_OBJECT_SPACE_SIZE = 67108864;
+intptr_t RESERVED_OBJECT_SPACE_SIZE = 0;
+
+
+/*
+ * The heap grows when marking takes more than GC_TIME_RATIO percent of the
+ * time (standard: 5), or when a collection leaves more than HIGH_OCCUPANCY
+ * percent of it in use. It shrinks after SHRINK_AFTER_COLLECTIONS
+ * collections in a row leaving less than LOW_OCCUPANCY percent in use, in
+ * less than half that time.
+ */
+intptr_t GC_TIME_RATIO = 5;
+
+#define HIGH_OCCUPANCY 75
+#define LOW_OCCUPANCY  25
+#define SHRINK_AFTER_COLLECTIONS 3
+
+int low_occupancy_collections = 0;
+
+/*
+ * only collections due to a full heap adapt its size, explicit ones do not
+ */
+bool heap_size_adaptable = false;
+
+
+/*
+ * the mark bitmap of the object_space
+ */
+uintptr_t* mark_bitmap = NULL;
+size_t mark_bitmap_words = 0;
+
+
+/*
+ * The heap is swept after marking by a background thread, while the
+ * interpreter resumes: sweep_word is the next word of the mark bitmap to be
+ * swept, and sweep_run_start the start of the free run ending at the next
+ * live object. The sweep proceeds in chunks of SWEEP_CHUNK_WORDS words of
+ * the bitmap, which is 16 kB of heap on 64 bit machines. Allocation only
+ * waits for the sweep when it needs more free space than has been swept,
+ * and then sweeps the next chunks itself.
+ * The free_lists and the sweep state are guarded by sweep_lock, which the
+ * interpreter holds while it collects the heap, and while it allocates from
+ * the free_lists during a sweep. Sweeps are started and completed by the
+ * interpreter, and the background sweeper leaves the heap alone in between
+ * as well as the allocation region, so allocations served by the region do
+ * not need the lock. The free space both add to is updated atomically.
+ * Finishing the sweep of the end of the heap, and adapting its size, is left
+ * to the interpreter, so that it is done in between its allocations.
  */
-intptr_t OBJECT_SPACE_SIZE = 1048576;
+#define SWEEP_CHUNK_WORDS 32
+
+size_t sweep_word = 0;
+void*  sweep_run_start = NULL;
+bool   sweep_pending = false;
+
+#define IS_SWEEPING() sweep_pending
+#define HAS_UNSWEPT_CHUNKS() (sweep_word < mark_bitmap_words)
+
+pthread_mutex_t sweep_lock;   // recursive
+pthread_cond_t  sweep_started;
+pthread_t       sweeper_thread;
+bool            sweeper_exiting;
 
 
 /*
@@ -82,338 +211,1857 @@ intptr_t BUFFERSIZE_FOR_UNINTERRUPTABLE = 50000;
 
 
 /*
- * reference to the first entry in the free_list
+ * the free_lists for the size classes, and for all larger chunks
+ */
+free_list_entry* size_class_free_lists[NUMBER_OF_SIZE_CLASSES];
+free_list_entry* large_free_list = NULL;
+
+
+/*
+ * the allocation region objects are bump-allocated from. It is a free
+ * chunk that has been taken out of the free_lists; the part between
+ * alloc_pointer and alloc_limit is still free.
+ */
+void* alloc_pointer = NULL;
+void* alloc_limit = NULL;
+
+
+/*
+ * if this counter equals 0, only then it is safe to collect the
+ * garbage. The counter is increased during initializations of
+ * VMObjects and the generation of classes
+ */
+int uninterruptable_counter = 0;
+
+
+size_t size_of_free_heap = 0;
+
+
+/*
+ * the number of objects in the object_space, which are not visited by the
+ * sweep if they are dead
+ */
+size_t num_objects_in_heap = 0;
+
+
+/*
+ * the nursery new objects are bump-allocated in, between nursery_start and
+ * nursery_top. nursery_size is 0 as long as there is no nursery.
+ */
+void*  nursery_start = NULL;
+void*  nursery_top = NULL;
+size_t nursery_size = 0;
+
+
+/*
+ * the size of the nursery (standard: 256 kB)
+ */
+intptr_t NURSERY_SIZE = 262144;
+
+
+/*
+ * set when the nursery is exhausted: new objects are allocated in the heap
+ * until the next safepoint of the interpreter performs a minor collection
+ */
+bool gc_collection_pending = false;
+
+
+/*
+ * A compaction slides all live objects to the start of the heap. It is
+ * performed by the next safepoint, when requested by System fullGC or when a
+ * sweep leaves more than FRAGMENTATION_THRESHOLD percent of the free space
+ * outside of its largest chunk.
+ */
+#define FRAGMENTATION_THRESHOLD 75
+
+bool compaction_pending = false;
+
+// the forward address of the next live object during a compaction
+void* compaction_top = NULL;
+
+// while compacting, the gc_field of a live object in the heap holds its
+// forward address, besides the GC bits
+#define GC_BITS ((intptr_t)(sizeof(void*) - 1))
+#define FORWARD_ADDRESS(O) ((pVMObject)((O)->gc_field & ~GC_BITS))
+
+
+/*
+ * if this counter is gt zero, objects are allocated in the heap directly.
+ * This is done for objects that are long-living anyway, or that are
+ * referenced from outside the heap, like classes, methods and symbols.
+ */
+int pretenured_counter = 0;
+
+
+/*
+ * The objects created while booting are bump-allocated in the boot space of
+ * at most BOOT_SPACE_SIZE bytes, boot_space_size of which are in use. They
+ * live as long as the VM, so that the collector neither marks nor sweeps
+ * them. Those which refer to objects outside of the boot space are kept in
+ * boot_roots, a remembered set scanned by every collection.
+ */
+#define BOOT_SPACE_SIZE 4194304
+
+void*  boot_space = NULL;
+size_t boot_space_size = 0;
+bool   boot_allocation = false;
+
+
+/*
+ * growable stacks of objects, for the remembered set and the objects
+ * promoted by a minor collection whose references still need to be
+ * evacuated
+ */
+typedef struct _object_stack {
+    pVMObject* elements;
+    size_t     size;
+    size_t     capacity;
+} object_stack;
+
+
+object_stack remembered_set;
+object_stack promoted_objects;
+object_stack boot_roots;
+
+
+/*
+ * Marking is done by MARK_THREADS workers (standard: 1), the first of which
+ * is the thread of the interpreter. The others are a pool of threads that
+ * only run while the interpreter waits for the marking to finish.
+ * Each worker has a mark stack of the references it has found, but whose
+ * objects it has not visited yet. Once it holds enough, part of them is
+ * moved to the shared stack of the worker, from where idle workers steal.
+ */
+typedef struct _mark_worker {
+    object_stack    stack;
+    object_stack    shared;
+    size_t          shared_size; // read by thieves without taking the lock
+    pthread_mutex_t lock;        // guards shared
+    pthread_t       thread;
+    uint32_t        num_live;
+    uint32_t        spc_live;
+    uint32_t        max_depth;
+} mark_worker;
+
+#define SHARE_THRESHOLD 64
+
+intptr_t MARK_THREADS = 1;
+
+mark_worker* mark_workers = NULL;
+static __thread mark_worker* current_mark_worker;
+
+// the pool is started by incrementing mark_round, and a round of marking is
+// over once all workers are idle at the same time
+pthread_mutex_t mark_pool_lock;
+pthread_cond_t  mark_round_started;
+pthread_cond_t  mark_round_finished;
+uint32_t mark_round;
+uint32_t mark_threads_finished;
+bool     mark_pool_exiting;
+uint32_t idle_mark_workers;
+
+
+/*
+ * With a target maximum pause MAX_MARK_PAUSE in us (standard: 0, marking
+ * stops the interpreter until it is done), the heap is marked incrementally.
+ * The marking starts once the free space has dropped to
+ * INCREMENTAL_START_BUFFERS times the buffer, and proceeds in slices of at
+ * most that time whenever slice_allocation bytes have been allocated in the
+ * heap. Marked objects are black, those on the mark stack grey, and all
+ * others white; the write barrier shades stored objects grey, so that no
+ * black object refers to a white one.
+ * Objects that may have been written to without barrier - the frames
+ * executed while marking, and the objects allocated meanwhile - are dirty.
+ * The slices scan them once the mark stack is empty; a frame becomes dirty
+ * again whenever the interpreter returns to it, and the current frame stays
+ * dirty. The final pause scans the dirty objects left, along with the roots
+ * and the nursery, which the slices leave alone, since minor collections
+ * move its objects. It follows the first slice that runs out of work.
+ */
+#define INCREMENTAL_START_BUFFERS 3
+#define MIN_MARK_SLICES 16
+#define SLICE_CHECK_INTERVAL 256
+
+intptr_t MAX_MARK_PAUSE = 0;
+
+bool   gc_marking_incrementally = false;
+bool   mark_slices_done;
+size_t slice_allocation;
+size_t allocated_since_slice;
+
+object_stack dirty_objects;
+size_t       dirty_objects_scanned;
+
+
+/*
+ * objects in the object_space that own memory outside of it, which is
+ * released by sending them free once they are found dead
+ */
+object_stack objects_with_external_storage;
+
+
+//
+// values for GC statistics
+//
+
+
+uint32_t num_collections; // the number of collections performed
+uint32_t num_live;        // number of live objects (per collection)
+uint32_t spc_live;        // space consumed by live objects (per collection)
+uint32_t num_freed;       // number of freed objects (per collection)
+uint32_t spc_freed;       // freed space (per collection)
+uint32_t num_alloc;       // number of allocated objects (since last collection)
+uint32_t spc_alloc;       // allocated space (since last collection)
+uint32_t num_minor_collections; // the number of minor collections performed
+uint32_t num_promoted;    // number of promoted objects (per minor collection)
+uint32_t spc_promoted;    // promoted space (per minor collection)
+uint64_t spc_promoted_total; // promoted space (in all minor collections)
+uint32_t max_mark_depth;  // maximum size of the mark stack (per collection)
+uint32_t max_mark_depth_total; // maximum size of the mark stack (overall)
+size_t   num_objects_at_mark; // objects in the heap when it was marked
+size_t   spc_used_at_mark;    // heap space in use when it was marked
+size_t   num_swept_live;  // live objects found by the sweep (per collection)
+size_t   spc_swept_live;  // space of these objects (per collection)
+int64_t  mark_time;       // time spent marking in us (per collection)
+int64_t  sweep_time;      // time spent sweeping in us (per collection)
+int64_t  interpreter_sweep_time; // part of it on the interpreter thread
+int64_t  mark_time_total; // time spent marking in us (overall)
+int64_t  sweep_time_total; // time spent sweeping in us (overall)
+int64_t  mutator_time;    // time between the last two collections in us
+int64_t  last_collection_end; // when the last mark phase ended
+uint32_t num_heap_grown;  // number of times the heap has grown
+uint32_t num_heap_shrunk; // number of times the heap has shrunk
+uint32_t num_compactions; // number of compacting collections
+int64_t  compact_time;    // time spent moving objects in us (per compaction)
+int64_t  compact_time_total; // time spent moving objects in us (overall)
+uint32_t num_mark_slices; // number of incremental marking slices
+int64_t  max_mark_pause;  // longest pause for marking in us (overall)
+uint32_t num_boot_roots;  // number of objects in the boot space that are roots
+
+
+//
+// forward declarations
+//
+
+
+void gc_add_free_entry(void* start, size_t size);
+void gc_clear_free_lists(void);
+void gc_initialize(void);
+void gc_release_allocation_region(void);
+void gc_take_allocation_region(size_t size);
+void gc_sweep_run(void* start, void* end);
+void gc_sweep_step(void);
+int64_t gc_sweep_chunk(void);
+void gc_complete_sweep(void);
+void* gc_sweeper(void* unused);
+void gc_start_sweeper(void);
+void gc_stop_sweeper(void);
+void gc_sweep_until(size_t free_space);
+void gc_finish_sweep(void);
+int64_t gc_microseconds(void);
+void gc_collect_for_allocation(void);
+void gc_process_mark_stack(mark_worker* worker);
+bool gc_try_mark(pVMObject object);
+void gc_mark_in_parallel(void);
+void gc_mark_concurrently(mark_worker* worker);
+void gc_share_work(mark_worker* worker);
+bool gc_take_work(mark_worker* worker);
+bool gc_wait_for_work(mark_worker* worker);
+void* gc_mark_thread(void* worker);
+void gc_start_mark_threads(void);
+void gc_stop_mark_threads(void);
+void gc_process_mark_stacks(void);
+void gc_begin_marking(void);
+void gc_mark_incrementally(void);
+void gc_start_incremental_marking(void);
+void gc_mark_slice(void);
+void gc_finish_incremental_marking(void);
+void gc_abort_incremental_marking(void);
+void gc_scan_again(pVMObject object);
+void gc_check_fragmentation(void);
+void* gc_allocate_boot_object(size_t size);
+void gc_walk_boot_roots(walk_heap_fn walk);
+void gc_compact(void);
+void gc_visit_marked_objects(void (*visit)(pVMObject));
+void gc_set_forward_address(pVMObject object);
+void gc_update_references(pVMObject object);
+void gc_move_object(pVMObject object);
+pVMObject gc_forward(pVMObject object);
+bool gc_grow_heap(size_t size, bool beyond_maximum);
+bool gc_find_allocation_region(size_t size);
+void gc_shrink_heap(free_list_entry* tail);
+void gc_adapt_heap_size(free_list_entry* tail);
+void* gc_reserve_space(size_t size);
+void gc_release_space(void* start, size_t size);
+void gc_discard_space(void* start, size_t size);
+void object_stack_push(object_stack* stack, pVMObject object);
+void object_stack_free(object_stack* stack);
+
+
+void init_stat(void);
+void init_collect_stat(void);
+void collect_stat(void);
+void reset_alloc_stat(void);
+void collect_minor_stat(void);
+void sweep_stat(void);
+void heap_size_stat(const char* change);
+void compact_stat(void);
+
+
+//
+// implementations
+//
+
+
+void gc_set_heap_size(uint32_t heap_size) {
+    // this can only be done before the heap is initialised - afterwards, it
+    // yields an error message and terminates the VM
+    if (object_space != NULL) {
+        Universe_error_exit("attempt to change heap size after initialisation");
+    }
+    INITIAL_OBJECT_SPACE_SIZE = 1024 * 1024 * heap_size;
+}
+
+
+void gc_set_max_heap_size(uint32_t max_heap_size) {
+    if (object_space != NULL) {
+        Universe_error_exit("attempt to change maximum heap size after initialisation");
+    }
+    MAX_OBJECT_SPACE_SIZE = 1024 * 1024 * max_heap_size;
+}
+
+
+void gc_set_gc_time_ratio(uint32_t gc_time_ratio) {
+    GC_TIME_RATIO = gc_time_ratio;
+}
+
+
+void gc_set_mark_threads(uint32_t mark_threads) {
+    if (object_space != NULL) {
+        Universe_error_exit("attempt to change mark threads after initialisation");
+    }
+    MARK_THREADS = mark_threads > 0 ? mark_threads : 1;
+}
+
+
+void gc_set_max_pause(uint32_t max_pause) {
+    if (object_space != NULL) {
+        Universe_error_exit("attempt to change maximum pause after initialisation");
+    }
+    MAX_MARK_PAUSE = 1000 * max_pause;
+}
+
+
+void gc_set_nursery_size(uint32_t nursery_size) {
+    // as the heap size, this can only be done before initialisation
+    if (object_space != NULL) {
+        Universe_error_exit("attempt to change nursery size after initialisation");
+    }
+    NURSERY_SIZE = 1024 * nursery_size;
+}
+
+
+/**
+ * Objects in the object_space are marked in the mark bitmap, young ones in
+ * their gc_field, since the nursery is not swept.
+ */
+bool gc_is_marked(pVMObject object) {
+    if (IS_YOUNG(object))
+        return object->gc_field & GC_MARKED;
+    size_t index = MARK_BIT_INDEX(object);
+    return (mark_bitmap[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+}
+
+
+void gc_set_marked(pVMObject object) {
+    if (IS_YOUNG(object)) {
+        object->gc_field |= GC_MARKED;
+    } else {
+        size_t index = MARK_BIT_INDEX(object);
+        mark_bitmap[index / BITS_PER_WORD] |= (uintptr_t)1 << (index % BITS_PER_WORD);
+    }
+}
+
+
+/**
+ * Visit the objects on the mark stack until it is empty: unmarked ones are
+ * marked and told to 'walk_references', which pushes their references.
+ */
+void gc_process_mark_stack(mark_worker* worker) {
+    while (worker->stack.size > 0) {
+        pVMObject object = worker->stack.elements[--worker->stack.size];
+        if (gc_is_marked(object))
+            continue;
+        gc_set_marked(object);
+        worker->num_live++;
+        worker->spc_live += object->object_size;
+        SEND(object, walk_references, gc_mark_object);
+    }
+}
+
+
+/**
+ * Mark the object unless another worker has done so, in which case false is
+ * returned.
+ */
+bool gc_try_mark(pVMObject object) {
+    if (IS_YOUNG(object))
+        return !(__atomic_fetch_or(&object->gc_field, GC_MARKED,
+                                   __ATOMIC_RELAXED) & GC_MARKED);
+    size_t index = MARK_BIT_INDEX(object);
+    uintptr_t bit = (uintptr_t)1 << (index % BITS_PER_WORD);
+    uintptr_t* word = &mark_bitmap[index / BITS_PER_WORD];
+    // most objects found marked are so already before the atomic operation
+    if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit)
+        return false;
+    return !(__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit);
+}
+
+
+/**
+ * Let the mark threads join the interpreter thread in visiting the objects
+ * on its mark stack, and wait for all of them to finish.
+ */
+void gc_mark_in_parallel() {
+    idle_mark_workers = 0;
+    pthread_mutex_lock(&mark_pool_lock);
+    mark_threads_finished = 0;
+    mark_round++;
+    pthread_cond_broadcast(&mark_round_started);
+    pthread_mutex_unlock(&mark_pool_lock);
+    
+    gc_mark_concurrently(&mark_workers[0]);
+    
+    pthread_mutex_lock(&mark_pool_lock);
+    while (mark_threads_finished < MARK_THREADS - 1)
+        pthread_cond_wait(&mark_round_finished, &mark_pool_lock);
+    pthread_mutex_unlock(&mark_pool_lock);
+}
+
+
+/**
+ * The work of a worker in a round of parallel marking: it visits the objects
+ * on its mark stack, sharing some of them while it has many, and steals from
+ * the other workers when it has run out.
+ */
+void gc_mark_concurrently(mark_worker* worker) {
+    do {
+        while (worker->stack.size > 0) {
+            pVMObject object = worker->stack.elements[--worker->stack.size];
+            if (!gc_try_mark(object))
+                continue;
+            worker->num_live++;
+            worker->spc_live += object->object_size;
+            SEND(object, walk_references, gc_mark_object);
+            
+            if (   (worker->stack.size >= SHARE_THRESHOLD)
+                && (__atomic_load_n(&worker->shared_size, __ATOMIC_RELAXED) == 0))
+                gc_share_work(worker);
+        }
+    } while (gc_take_work(worker) || gc_wait_for_work(worker));
+}
+
+
+/**
+ * Move the older half of the mark stack of the worker to its shared stack.
+ */
+void gc_share_work(mark_worker* worker) {
+    size_t half = worker->stack.size / 2;
+    pthread_mutex_lock(&worker->lock);
+    for (size_t i = 0; i < half; i++)
+        object_stack_push(&worker->shared, worker->stack.elements[i]);
+    __atomic_store_n(&worker->shared_size, worker->shared.size, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&worker->lock);
+    
+    worker->stack.size -= half;
+    memmove(worker->stack.elements, &worker->stack.elements[half],
+            worker->stack.size * sizeof(pVMObject));
+}
+
+
+/**
+ * Take half of the shared stack of the first worker that has shared any,
+ * starting with the worker itself. Return false if none has.
+ */
+bool gc_take_work(mark_worker* worker) {
+    size_t self = worker - mark_workers;
+    for (size_t i = 0; i < (size_t)MARK_THREADS; i++) {
+        mark_worker* victim = &mark_workers[(self + i) % MARK_THREADS];
+        if (__atomic_load_n(&victim->shared_size, __ATOMIC_RELAXED) == 0)
+            continue;
+        
+        pthread_mutex_lock(&victim->lock);
+        size_t taken = (victim->shared.size + 1) / 2;
+        for (size_t j = 0; j < taken; j++)
+            object_stack_push(&worker->stack,
+                victim->shared.elements[--victim->shared.size]);
+        __atomic_store_n(&victim->shared_size, victim->shared.size, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&victim->lock);
+        
+        if (taken > 0)
+            return true;
+    }
+    return false;
+}
+
+
+/**
+ * Wait as an idle worker until there is work to steal, which returns true,
+ * or until all workers are idle, which ends the round. Since a worker only
+ * becomes idle with an empty shared stack, and only adds to its own, no
+ * work is left then.
  */
-free_list_entry* first_free_entry = NULL;
+bool gc_wait_for_work(mark_worker* worker) {
+    __atomic_add_fetch(&idle_mark_workers, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&idle_mark_workers, __ATOMIC_SEQ_CST) < MARK_THREADS) {
+        for (size_t i = 0; i < (size_t)MARK_THREADS; i++) {
+            if (__atomic_load_n(&mark_workers[i].shared_size, __ATOMIC_RELAXED) == 0)
+                continue;
+            __atomic_sub_fetch(&idle_mark_workers, 1, __ATOMIC_SEQ_CST);
+            if (gc_take_work(worker))
+                return true;
+            __atomic_add_fetch(&idle_mark_workers, 1, __ATOMIC_SEQ_CST);
+            break;
+        }
+        sched_yield();
+    }
+    return false;
+}
+
+
+void* gc_mark_thread(void* worker) {
+    current_mark_worker = (mark_worker*)worker;
+    uint32_t round = 0;
+    pthread_mutex_lock(&mark_pool_lock);
+    while (true) {
+        while (mark_round == round && !mark_pool_exiting)
+            pthread_cond_wait(&mark_round_started, &mark_pool_lock);
+        if (mark_pool_exiting)
+            break;
+        round = mark_round;
+        pthread_mutex_unlock(&mark_pool_lock);
+        
+        gc_mark_concurrently(current_mark_worker);
+        
+        pthread_mutex_lock(&mark_pool_lock);
+        if (++mark_threads_finished == MARK_THREADS - 1)
+            pthread_cond_signal(&mark_round_finished);
+    }
+    pthread_mutex_unlock(&mark_pool_lock);
+    return NULL;
+}
+
+
+void gc_start_mark_threads() {
+    mark_workers = (mark_worker*)internal_allocate(
+        MARK_THREADS * sizeof(mark_worker));
+    memset(mark_workers, 0, MARK_THREADS * sizeof(mark_worker));
+    current_mark_worker = &mark_workers[0];
+    if (MARK_THREADS == 1)
+        return;
+    
+    pthread_mutex_init(&mark_pool_lock, NULL);
+    pthread_cond_init(&mark_round_started, NULL);
+    pthread_cond_init(&mark_round_finished, NULL);
+    mark_round = 0;
+    mark_pool_exiting = false;
+    for (intptr_t i = 0; i < MARK_THREADS; i++)
+        pthread_mutex_init(&mark_workers[i].lock, NULL);
+    for (intptr_t i = 1; i < MARK_THREADS; i++) {
+        if (pthread_create(&mark_workers[i].thread, NULL, gc_mark_thread,
+                           &mark_workers[i]) != 0) {
+            debug_error("Failed to start the mark threads. Panic.\n");
+            Universe_exit(-1);
+        }
+    }
+}
+
+
+void gc_stop_mark_threads() {
+    if (MARK_THREADS > 1) {
+        pthread_mutex_lock(&mark_pool_lock);
+        mark_pool_exiting = true;
+        pthread_cond_broadcast(&mark_round_started);
+        pthread_mutex_unlock(&mark_pool_lock);
+        for (intptr_t i = 1; i < MARK_THREADS; i++)
+            pthread_join(mark_workers[i].thread, NULL);
+        for (intptr_t i = 0; i < MARK_THREADS; i++)
+            pthread_mutex_destroy(&mark_workers[i].lock);
+        pthread_cond_destroy(&mark_round_finished);
+        pthread_cond_destroy(&mark_round_started);
+        pthread_mutex_destroy(&mark_pool_lock);
+    }
+    for (intptr_t i = 0; i < MARK_THREADS; i++) {
+        object_stack_free(&mark_workers[i].stack);
+        object_stack_free(&mark_workers[i].shared);
+    }
+    internal_free(mark_workers);
+    mark_workers = NULL;
+}
+
+
+void gc_mark_reachable_objects() {
+    // mark the globals, the symbols and the special objects of the VM
+    Universe_walk_globals(gc_mark_object);
+    gc_walk_boot_roots(gc_mark_object);
+        
+    // Get the current frame and mark it.
+    // Since marking is done transitively, this automatically
+    // marks the whole stack
+    pVMFrame current_frame = (pVMFrame) Interpreter_get_frame();
+    if (current_frame != NULL) {
+        gc_mark_object((pVMObject)current_frame);
+    }
+    
+    gc_process_mark_stacks();
+}
+
+
+/**
+ * Visit the objects on the mark stacks until all reachable ones are marked.
+ */
+void gc_process_mark_stacks() {
+    if (MARK_THREADS > 1)
+        gc_mark_in_parallel();
+    else
+        gc_process_mark_stack(&mark_workers[0]);
+    
+    for (intptr_t i = 0; i < MARK_THREADS; i++) {
+        mark_worker* worker = &mark_workers[i];
+        num_live += worker->num_live;
+        spc_live += worker->spc_live;
+        if (worker->max_depth > max_mark_depth)
+            max_mark_depth = worker->max_depth;
+        worker->num_live = worker->spc_live = worker->max_depth = 0;
+    }
+}
+
+
+/**
+ *  check whether the object is inside the managed heap or the nursery
+ *  if it isn't, there is no VMObject to mark, otherwise
+ *  it is pushed onto the mark stack, without touching it yet.
+ *  gc_process_mark_stack marks it and pushes its references
+ *  later on.
+ */
+pVMObject gc_mark_object(pVMObject self) {
+    // immediates have no heap storage
+    if (IS_IMMEDIATE(self))
+        return self;
+    if (   (   ((void*) self >= (void*)  object_space) 
+            && ((void*) self <= (void*) ((intptr_t) object_space + OBJECT_SPACE_SIZE)))
+        || (IS_YOUNG(self) && !gc_marking_incrementally))
+    {
+        mark_worker* worker = current_mark_worker;
+        PREFETCH(self);
+        object_stack_push(&worker->stack, self);
+        if (worker->stack.size > worker->max_depth)
+            worker->max_depth = worker->stack.size;
+    }
+    return self;
+}
+
+
+/**
+ * Push an object from the heap that has been stored into another one while
+ * marking incrementally, unless it has been marked already, or is dirty and
+ * will be scanned anyway.
+ */
+void gc_shade(pVMObject object) {
+    if (   !IS_IMMEDIATE(object)
+        && ((void*)object >= object_space)
+        && ((void*)object < (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE))
+        && !(object->gc_field & GC_DIRTY)
+        && !gc_is_marked(object))
+        gc_mark_object(object);
+}
+
+
+/**
+ * Put the object from the heap into the list of objects to be scanned again
+ * by the final pause of the incremental marking.
+ */
+void gc_mark_dirty(void* object) {
+    ((pOOObject)object)->gc_field |= GC_DIRTY;
+    object_stack_push(&dirty_objects, (pVMObject)object);
+}
+
+
+/**
+ * Put the object from the heap into the remembered set.
+ */
+void gc_remember(void* object) {
+    ((pOOObject)object)->gc_field |= GC_REMEMBERED;
+    object_stack_push(&remembered_set, (pVMObject)object);
+}
+
+
+/**
+ * Put the object from the boot space into the boot_roots, which it never
+ * leaves again.
+ */
+void gc_add_boot_root(void* object) {
+    ((pOOObject)object)->gc_field |= GC_BOOT_ROOT;
+    object_stack_push(&boot_roots, (pVMObject)object);
+    num_boot_roots++;
+}
+
+
+/**
+ * Let walk visit, and possibly replace, the references of the boot_roots.
+ */
+void gc_walk_boot_roots(walk_heap_fn walk) {
+    for (size_t i = 0; i < boot_roots.size; i++)
+        SEND(boot_roots.elements[i], walk_references, walk);
+}
+
+
+/**
+ * Remove all entries from the remembered set that have not been marked,
+ * so that they can be freed by the sweep. Objects in the boot space are
+ * never marked, but live anyway.
+ */
+void gc_prune_remembered_set() {
+    size_t kept = 0;
+    for (size_t i = 0; i < remembered_set.size; i++) {
+        pVMObject object = remembered_set.elements[i];
+        if (IS_BOOT_OBJECT(object) || gc_is_marked(object))
+            remembered_set.elements[kept++] = object;
+    }
+    remembered_set.size = kept;
+}
+
+
+/**
+ * Put the object from the heap into the list of objects that have to be sent
+ * free when they die.
+ */
+void gc_register_external_storage(void* object) {
+    if (IS_BOOT_OBJECT(object)) {
+        if (!(((pOOObject)object)->gc_field & GC_BOOT_ROOT))
+            gc_add_boot_root(object);
+        return;
+    }
+    object_stack_push(&objects_with_external_storage, (pVMObject)object);
+}
+
+
+/**
+ * Send free to all registered objects that have not been marked, since the
+ * sweep does not visit dead objects.
+ */
+void gc_release_external_storage() {
+    size_t kept = 0;
+    for (size_t i = 0; i < objects_with_external_storage.size; i++) {
+        pVMObject object = objects_with_external_storage.elements[i];
+        if (gc_is_marked(object))
+            objects_with_external_storage.elements[kept++] = object;
+        else
+            SEND(object, free);
+    }
+    objects_with_external_storage.size = kept;
+}
+
+
+/**
+ * Remove the markings of the objects in the nursery, which is not swept.
+ */
+void gc_unmark_nursery() {
+    for (void* pointer = nursery_start; pointer < nursery_top;
+         pointer = (void*)((intptr_t)pointer + ((pOOObject)pointer)->object_size))
+        ((pOOObject)pointer)->gc_field = 0;
+}
+
+
+/**
+ * For debugging - the layout of the heap is shown.
+ * This function uses 
+ * - '[size]' for free space,
+ * - '-xx-' for marked objects, and
+ * - '-size-' for unmarked objects.
+ * The output is also aligned to improve readability.
+ */
+void gc_show_memory() {
+    pVMObject pointer = object_space;
+    intptr_t object_size = 0;
+    intptr_t object_aligner = 0;
+    int line_count = 2;
+    
+    fprintf(stderr,"\n########\n# SHOW #\n########\n1 ");
+    
+    do {
+        if (IS_FREE_CHUNK(pointer)) {
+            object_size = ((free_list_entry*)pointer)->size;
+            fprintf(stderr, "[%ld]", object_size);
+        } else {
+            pVMObject object = (pVMObject) pointer;
+            
+            object_size = SEND(object, object_size);
+            
+            // is this object marked or not?
+            if (gc_is_marked(object)) {
+                fprintf(stderr,"-xx-");
+            } else {
+                pVMSymbol class_name = SEND(SEND(object, get_class), get_name);
+                fprintf(stderr,"|%ld %s %p", object_size, SEND(class_name, get_plain_string), object);
+            }
+        }
+        // aligns the output by inserting a line break after 36 objects
+        object_aligner++;
+        if (object_aligner == 36) {
+            fprintf(stderr,"\n%d ", line_count++);
+            object_aligner = 0;
+        }
+        pointer = (void*)((intptr_t)pointer + object_size);
+    } while ((void*)pointer < (void*)((intptr_t) object_space + OBJECT_SPACE_SIZE));
+}
+
+
+int64_t gc_microseconds() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+
+/**
+ * Sweep the next chunk of the heap, or complete the sweep once all chunks
+ * have been swept.
+ */
+void gc_sweep_step() {
+    pthread_mutex_lock(&sweep_lock);
+    if (HAS_UNSWEPT_CHUNKS())
+        interpreter_sweep_time += gc_sweep_chunk();
+    else if (sweep_pending)
+        gc_complete_sweep();
+    pthread_mutex_unlock(&sweep_lock);
+}
+
+
+/**
+ * Sweep the next SWEEP_CHUNK_WORDS words of the mark bitmap. Only the live
+ * objects are visited, found by scanning the bitmap: the space between two
+ * of them consists of free chunks and dead objects only, and is combined
+ * into one free run, which is added to the free_lists. The caller holds the
+ * sweep_lock. Return the time it took in us.
+ */
+int64_t gc_sweep_chunk() {
+    int64_t start_time = gc_microseconds();
+    size_t end_word = sweep_word + SWEEP_CHUNK_WORDS;
+    if (end_word > mark_bitmap_words)
+        end_word = mark_bitmap_words;
+    
+    for (; sweep_word < end_word; sweep_word++) {
+        uintptr_t bits = mark_bitmap[sweep_word];
+        if (bits == 0)
+            continue;
+        num_swept_live += POPULATION_COUNT(bits);
+        do {
+            size_t index = sweep_word * BITS_PER_WORD + COUNT_TRAILING_ZEROS(bits);
+            pVMObject object =
+                (pVMObject)((intptr_t)object_space + index * sizeof(void*));
+            gc_sweep_run(sweep_run_start, object);
+            sweep_run_start = (void*)((intptr_t)object + object->object_size);
+            spc_swept_live += object->object_size;
+            bits &= bits - 1;
+        } while (bits != 0);
+        // remove the markings
+        mark_bitmap[sweep_word] = 0;
+    }
+    
+    int64_t time = gc_microseconds() - start_time;
+    sweep_time += time;
+    return time;
+}
+
+
+/**
+ * Add the free run at the end of the heap, once all chunks have been swept,
+ * and adapt the heap to the outcome of the collection. This is done by the
+ * interpreter, holding the sweep_lock.
+ */
+void gc_complete_sweep() {
+    void* heap_end = (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE);
+    free_list_entry* tail =
+        sweep_run_start < heap_end ? (free_list_entry*)sweep_run_start : NULL;
+    gc_sweep_run(sweep_run_start, heap_end);
+    sweep_pending = false;
+    num_objects_in_heap += num_swept_live;
+    num_freed = num_objects_at_mark - num_swept_live;
+    spc_freed = spc_used_at_mark - spc_swept_live;
+    
+    sweep_time_total += sweep_time;
+    if(gc_verbosity > 1)
+        sweep_stat();
+    
+    if (heap_size_adaptable)
+        gc_adapt_heap_size(tail);
+    gc_check_fragmentation();
+}
+
+
+/**
+ * The background sweeper sweeps chunk by chunk as long as there are any
+ * left, and releases the sweep_lock in between, so that the interpreter can
+ * allocate from the chunks swept so far.
+ */
+void* gc_sweeper(void* unused) {
+    pthread_mutex_lock(&sweep_lock);
+    while (!sweeper_exiting) {
+        if (HAS_UNSWEPT_CHUNKS()) {
+            gc_sweep_chunk();
+            pthread_mutex_unlock(&sweep_lock);
+            sched_yield();
+            pthread_mutex_lock(&sweep_lock);
+        } else {
+            pthread_cond_wait(&sweep_started, &sweep_lock);
+        }
+    }
+    pthread_mutex_unlock(&sweep_lock);
+    return NULL;
+}
+
+
+void gc_start_sweeper() {
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&sweep_lock, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    pthread_cond_init(&sweep_started, NULL);
+    sweeper_exiting = false;
+    if (pthread_create(&sweeper_thread, NULL, gc_sweeper, NULL) != 0) {
+        debug_error("Failed to start the sweeper thread. Panic.\n");
+        Universe_exit(-1);
+    }
+}
+
+
+void gc_stop_sweeper() {
+    pthread_mutex_lock(&sweep_lock);
+    sweeper_exiting = true;
+    pthread_cond_signal(&sweep_started);
+    pthread_mutex_unlock(&sweep_lock);
+    pthread_join(sweeper_thread, NULL);
+    pthread_cond_destroy(&sweep_started);
+    pthread_mutex_destroy(&sweep_lock);
+}
+
+
+/**
+ * Request a compaction if the largest free chunk, including the allocation
+ * region, holds too little of the free space.
+ */
+void gc_check_fragmentation() {
+    size_t largest = (intptr_t)alloc_limit - (intptr_t)alloc_pointer;
+    for (free_list_entry* entry = large_free_list; entry != NULL;
+         entry = entry->next) {
+        if (entry->size > largest)
+            largest = entry->size;
+    }
+    if (largest * 100 < (100 - FRAGMENTATION_THRESHOLD) * size_of_free_heap)
+        gc_request_compaction();
+}
+
+
+void gc_collect_for_allocation() {
+    gc_collect();
+    heap_size_adaptable = true;
+}
+
+
+/**
+ * Called once a collection has been swept, with the free run at the end of
+ * the heap, if there is one.
+ */
+void gc_adapt_heap_size(free_list_entry* tail) {
+    // sweeping the heap takes time in proportion to its size, as does
+    // allocating it full, so only the marking time is lowered by growing it
+    int64_t gc_time = mark_time;
+    if (   (gc_time * 100 > GC_TIME_RATIO * mutator_time)
+        || (spc_swept_live * 100 > HIGH_OCCUPANCY * OBJECT_SPACE_SIZE)) {
+        low_occupancy_collections = 0;
+        gc_grow_heap(0, false);
+    } else if (   (spc_swept_live * 100 < LOW_OCCUPANCY * OBJECT_SPACE_SIZE)
+               && (gc_time * 200 < GC_TIME_RATIO * mutator_time)) {
+        if (++low_occupancy_collections >= SHRINK_AFTER_COLLECTIONS) {
+            low_occupancy_collections = 0;
+            gc_shrink_heap(tail);
+        }
+    } else {
+        low_occupancy_collections = 0;
+    }
+}
+
+
+/**
+ * Add chunks to the end of the heap, enough to hold an object of the given
+ * size, up to the maximum heap size or, if beyond_maximum is set, the
+ * reserved space. This must not happen while the heap is being swept.
+ */
+bool gc_grow_heap(size_t size, bool beyond_maximum) {
+    size_t growth = INITIAL_OBJECT_SPACE_SIZE;
+    while (growth < size + sizeof(struct _free_list_entry))
+        growth += INITIAL_OBJECT_SPACE_SIZE;
+    if (OBJECT_SPACE_SIZE + growth > (beyond_maximum
+            ? RESERVED_OBJECT_SPACE_SIZE : MAX_OBJECT_SPACE_SIZE))
+        return false;
+    
+    // the reserved space behind the heap is zeroed
+    void* old_end = (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE);
+    OBJECT_SPACE_SIZE += growth;
+    mark_bitmap_words = OBJECT_SPACE_SIZE / sizeof(void*) / BITS_PER_WORD;
+    sweep_word = mark_bitmap_words;
+    BUFFERSIZE_FOR_UNINTERRUPTABLE = (intptr_t) (OBJECT_SPACE_SIZE * 0.1);
+    gc_add_free_entry(old_end, growth);
+    size_of_free_heap += growth;
+    
+    num_heap_grown++;
+    if(gc_verbosity > 1)
+        heap_size_stat("grown");
+    return true;
+}
+
+
+/**
+ * Give the last chunk of the heap back, if it is part of the given free run
+ * at its end.
+ */
+void gc_shrink_heap(free_list_entry* tail) {
+    size_t shrinkage = INITIAL_OBJECT_SPACE_SIZE;
+    if (   (tail == NULL)
+        || (OBJECT_SPACE_SIZE - shrinkage < INITIAL_OBJECT_SPACE_SIZE)
+        || (tail->size < shrinkage)
+        || (   (tail->size != shrinkage)
+            && (tail->size - shrinkage < sizeof(struct _free_list_entry))))
+        return;
+    
+    // remove the run from its free_list; the remainder is added again
+    free_list_entry** link = tail->size <= LARGEST_SIZE_CLASS
+        ? &size_class_free_lists[SIZE_CLASS(tail->size)]
+        : &large_free_list;
+    while (*link != NULL && *link != tail)
+        link = &(*link)->next;
+    if (*link == NULL)
+        return;
+    *link = tail->next;
+    size_t remainder = tail->size - shrinkage;
+    memset(tail, 0, sizeof(struct _free_list_entry));
+    if (remainder > 0)
+        gc_add_free_entry(tail, remainder);
+    
+    OBJECT_SPACE_SIZE -= shrinkage;
+    size_of_free_heap -= shrinkage;
+    mark_bitmap_words = OBJECT_SPACE_SIZE / sizeof(void*) / BITS_PER_WORD;
+    sweep_word = mark_bitmap_words;
+    BUFFERSIZE_FOR_UNINTERRUPTABLE = (intptr_t) (OBJECT_SPACE_SIZE * 0.1);
+    gc_discard_space((void*)((intptr_t)object_space + OBJECT_SPACE_SIZE),
+                     shrinkage);
+    
+    num_heap_shrunk++;
+    if(gc_verbosity > 1)
+        heap_size_stat("shrunk");
+}
+
+
+/*
+ * The maximum heap size is reserved as address space, of which only the
+ * part in use is backed by memory. Unused space reads as zeroes.
+ */
+void* gc_reserve_space(size_t size) {
+#ifdef CSOM_WIN
+    return calloc(1, size);
+#else
+    void* space = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return space == MAP_FAILED ? NULL : space;
+#endif
+}
+
+
+void gc_release_space(void* start, size_t size) {
+#ifdef CSOM_WIN
+    free(start);
+#else
+    munmap(start, size);
+#endif
+}
+
+
+void gc_discard_space(void* start, size_t size) {
+#ifdef CSOM_WIN
+    memset(start, 0, size);
+#else
+    madvise(start, size, MADV_DONTNEED);
+#endif
+}
+
+
+/**
+ * Sweep until more than the given amount of free space is available, or the
+ * whole heap has been swept.
+ */
+void gc_sweep_until(size_t free_space) {
+    while (IS_SWEEPING() && size_of_free_heap <= free_space)
+        gc_sweep_step();
+}
+
+
+void gc_finish_sweep() {
+    while (IS_SWEEPING())
+        gc_sweep_step();
+}
+
+
+/**
+ * Turn the space between start and end into a free chunk.
+ */
+void gc_sweep_run(void* start, void* end) {
+    size_t run_size = (intptr_t)end - (intptr_t)start;
+    if (run_size == 0)
+        return;
+    // free space is kept zeroed apart from the free_list entries, so that
+    // allocation does not need to clear it
+    memset(start, 0, run_size);
+    gc_add_free_entry(start, run_size);
+    __atomic_add_fetch(&size_of_free_heap, run_size, __ATOMIC_RELAXED);
+}
+
+
+/**
+ * Collect the heap, or finish the incremental marking in progress.
+ */
+void gc_collect() {
+    pthread_mutex_lock(&sweep_lock);
+    if (!gc_marking_incrementally) {
+        // the marks of the previous collection must have been swept
+        gc_finish_sweep();
+        gc_begin_marking();
+    }
+    
+    num_collections++;
+    int64_t start_time = gc_microseconds();
+    
+    // the heap is only parsable when the allocation region is free space
+    gc_release_allocation_region();
+    
+    if(gc_verbosity > 2) {
+        fprintf(stderr, "-- pre-collection heap dump --\n");
+        gc_show_memory();
+    }
+    
+    if (gc_marking_incrementally)
+        gc_finish_incremental_marking();
+    else
+        gc_mark_reachable_objects();
+    if (max_mark_depth > max_mark_depth_total)
+        max_mark_depth_total = max_mark_depth;
+    gc_prune_remembered_set();
+    gc_release_external_storage();
+    VMClass_flush_lookup_cache();
+    
+    // the free_lists are rebuilt by the background sweep
+    spc_used_at_mark = OBJECT_SPACE_SIZE - size_of_free_heap;
+    num_objects_at_mark = num_objects_in_heap;
+    num_objects_in_heap = 0;
+    num_swept_live = 0;
+    spc_swept_live = 0;
+    gc_clear_free_lists();
+    size_of_free_heap = 0;
+    sweep_word = 0;
+    sweep_run_start = object_space;
+    sweep_pending = true;
+    pthread_cond_signal(&sweep_started);
+    
+    gc_unmark_nursery();
+    last_collection_end = gc_microseconds();
+    int64_t pause = last_collection_end - start_time;
+    if (pause > max_mark_pause)
+        max_mark_pause = pause;
+    mark_time += pause;
+    mark_time_total += mark_time;
+    
+    if(gc_verbosity > 1)
+        collect_stat();
+    if(gc_verbosity > 2) {
+        gc_finish_sweep();
+        fprintf(stderr, "-- post-collection heap dump --\n");
+        gc_show_memory();
+    }
+    
+    reset_alloc_stat();
+    pthread_mutex_unlock(&sweep_lock);
+}
+
+
+void gc_begin_marking() {
+    heap_size_adaptable = false;
+    // the background sweeper does not take time from the interpreter
+    mutator_time =
+        gc_microseconds() - last_collection_end - interpreter_sweep_time;
+    init_collect_stat();
+}
+
+
+/**
+ * Called where a collection may be started: start the incremental marking
+ * once the free space runs low, or mark the next slice once enough has been
+ * allocated since the last one.
+ */
+void gc_mark_incrementally() {
+    if (!gc_marking_incrementally) {
+        if (   !IS_SWEEPING()
+            && (size_of_free_heap
+                <= INCREMENTAL_START_BUFFERS * BUFFERSIZE_FOR_UNINTERRUPTABLE))
+            gc_start_incremental_marking();
+    } else if (allocated_since_slice >= slice_allocation) {
+        if (!mark_slices_done)
+            gc_mark_slice();
+        else
+            // only the final pause is left
+            gc_collect_for_allocation();
+    }
+}
+
+
+/**
+ * Push the roots onto the mark stack, and spread the marking over the free
+ * space left above the buffer, in slices expected to take half of it.
+ */
+void gc_start_incremental_marking() {
+    int64_t start_time = gc_microseconds();
+    int64_t expected_mark_time = mark_time;
+    gc_begin_marking();
+    gc_marking_incrementally = true;
+    
+    Universe_walk_globals(gc_mark_object);
+    gc_walk_boot_roots(gc_mark_object);
+    pVMFrame current_frame = Interpreter_get_frame();
+    if (current_frame != NULL)
+        gc_mark_object((pVMObject)current_frame);
+    
+    size_t expected_slices = 2 * expected_mark_time / MAX_MARK_PAUSE + 1;
+    if (expected_slices < MIN_MARK_SLICES)
+        expected_slices = MIN_MARK_SLICES;
+    slice_allocation = (size_of_free_heap - BUFFERSIZE_FOR_UNINTERRUPTABLE)
+        / expected_slices;
+    allocated_since_slice = 0;
+    mark_slices_done = false;
+    
+    int64_t pause = gc_microseconds() - start_time;
+    if (pause > max_mark_pause)
+        max_mark_pause = pause;
+    mark_time += pause;
+}
+
+
+/**
+ * Visit the objects on the mark stack of the interpreter thread, and the
+ * dirty objects not scanned yet, for at most MAX_MARK_PAUSE. References to
+ * young objects are not followed.
+ */
+void gc_mark_slice() {
+    int64_t start_time = gc_microseconds();
+    mark_worker* worker = &mark_workers[0];
+    size_t visited = 0;
+    size_t dirty_end = dirty_objects.size;
+    mark_slices_done = true;
+    while (   (worker->stack.size > 0)
+           || (dirty_objects_scanned < dirty_end)) {
+        if (worker->stack.size == 0) {
+            pVMObject object = dirty_objects.elements[dirty_objects_scanned++];
+            if (object == (pVMObject)Interpreter_get_frame())
+                // still written to, it is scanned again by the final pause
+                object_stack_push(&dirty_objects, object);
+            else
+                object->gc_field &= ~GC_DIRTY;
+            gc_scan_again(object);
+        } else {
+            pVMObject object = worker->stack.elements[--worker->stack.size];
+            if (gc_is_marked(object))
+                continue;
+            gc_set_marked(object);
+            worker->num_live++;
+            worker->spc_live += object->object_size;
+            SEND(object, walk_references, gc_mark_object);
+        }
+        if (   (++visited % SLICE_CHECK_INTERVAL == 0)
+            && (gc_microseconds() - start_time >= MAX_MARK_PAUSE)) {
+            mark_slices_done = false;
+            break;
+        }
+    }
+    num_mark_slices++;
+    allocated_since_slice = 0;
+    
+    int64_t pause = gc_microseconds() - start_time;
+    if (pause > max_mark_pause)
+        max_mark_pause = pause;
+    mark_time += pause;
+}
+
+
+/**
+ * The final pause of the incremental marking scans the roots, the current
+ * frame, the dirty objects left and the objects in the nursery, and marks
+ * the objects found by them.
+ */
+void gc_finish_incremental_marking() {
+    gc_marking_incrementally = false;
+    
+    Universe_walk_globals(gc_mark_object);
+    gc_walk_boot_roots(gc_mark_object);
+    pVMFrame current_frame = Interpreter_get_frame();
+    if (current_frame != NULL)
+        gc_scan_again((pVMObject)current_frame);
+    
+    for (size_t i = dirty_objects_scanned; i < dirty_objects.size; i++) {
+        pVMObject object = dirty_objects.elements[i];
+        object->gc_field &= ~GC_DIRTY;
+        gc_scan_again(object);
+    }
+    dirty_objects.size = 0;
+    dirty_objects_scanned = 0;
+    
+    for (void* pointer = nursery_start; pointer < nursery_top;
+         pointer = (void*)((intptr_t)pointer + ((pOOObject)pointer)->object_size))
+        SEND((pVMObject)pointer, walk_references, gc_mark_object);
+    
+    gc_process_mark_stacks();
+}
+
+
+/**
+ * A compaction marks the heap anew, dropping the incremental marking in
+ * progress.
+ */
+void gc_abort_incremental_marking() {
+    if (!gc_marking_incrementally)
+        return;
+    gc_marking_incrementally = false;
+    for (intptr_t i = 0; i < MARK_THREADS; i++) {
+        mark_worker* worker = &mark_workers[i];
+        worker->stack.size = 0;
+        worker->num_live = worker->spc_live = worker->max_depth = 0;
+    }
+    for (size_t i = 0; i < dirty_objects.size; i++)
+        dirty_objects.elements[i]->gc_field &= ~GC_DIRTY;
+    dirty_objects.size = 0;
+    dirty_objects_scanned = 0;
+}
+
+
+/**
+ * Mark an object, and push its references even if it has been marked before.
+ */
+void gc_scan_again(pVMObject object) {
+    if (!gc_is_marked(object)) {
+        gc_set_marked(object);
+        mark_workers[0].num_live++;
+        mark_workers[0].spc_live += object->object_size;
+    }
+    SEND(object, walk_references, gc_mark_object);
+}
+
+
+/**
+ * Copy a young object into the heap, leaving a forward pointer to the copy
+ * in its gc_field. Objects in the nursery are never marked or remembered,
+ * so any other value than 0 is a forward pointer.
+ */
+pVMObject gc_evacuate(pVMObject self) {
+    if (!IS_YOUNG(self))
+        return self;
+    if (self->gc_field != 0)
+        return (pVMObject)self->gc_field;
+    
+    size_t size = self->object_size;
+    pVMObject copy = (pVMObject)gc_allocate(size);
+    memcpy(copy, self, size);
+    num_objects_in_heap++;
+    if (gc_marking_incrementally)
+        gc_mark_dirty(copy);
+    self->gc_field = (intptr_t)copy;
+    object_stack_push(&promoted_objects, copy);
+    
+    num_promoted++;
+    spc_promoted += size;
+    return copy;
+}
+
+
+/**
+ * A minor collection promotes all objects of the nursery that are reachable
+ * from the current frame or the remembered set into the heap, which takes
+ * time proportional to the survivors only. Since objects are moved, it may
+ * only be performed at safepoints of the interpreter, where no references
+ * are kept outside the heap.
+ */
+void gc_collect_minor() {
+    pthread_mutex_lock(&sweep_lock);
+    num_minor_collections++;
+    num_promoted = 0;
+    spc_promoted = 0;
+    gc_collection_pending = false;
+    
+    // make sure that all objects in the nursery can be promoted
+    size_t nursery_used = (intptr_t)nursery_top - (intptr_t)nursery_start;
+    gc_sweep_until(nursery_used + BUFFERSIZE_FOR_UNINTERRUPTABLE);
+    if (size_of_free_heap <= nursery_used + BUFFERSIZE_FOR_UNINTERRUPTABLE)
+        gc_collect_for_allocation();
+    
+    // the heap must not be collected while objects are moved
+    gc_start_uninterruptable_allocation();
+    
+    pVMFrame current_frame = Interpreter_get_frame();
+    if (current_frame != NULL)
+        Interpreter_set_frame((pVMFrame)gc_evacuate((pVMObject)current_frame));
+    
+    for (size_t i = 0; i < remembered_set.size; i++) {
+        pVMObject object = remembered_set.elements[i];
+        object->gc_field &= ~GC_REMEMBERED;
+        SEND(object, walk_references, gc_evacuate);
+    }
+    remembered_set.size = 0;
+    
+    // promoted objects never refer to the nursery again, since all their
+    // young references are promoted as well
+    while (promoted_objects.size > 0) {
+        pVMObject object = promoted_objects.elements[--promoted_objects.size];
+        SEND(object, walk_references, gc_evacuate);
+    }
+    
+    gc_end_uninterruptable_allocation();
+    
+    // the nursery is empty again
+    memset(nursery_start, 0, nursery_used);
+    nursery_top = nursery_start;
+    spc_promoted_total += spc_promoted;
+    
+    if(gc_verbosity > 1)
+        collect_minor_stat();
+    
+    gc_sweep_until(BUFFERSIZE_FOR_UNINTERRUPTABLE);
+    if (size_of_free_heap <= BUFFERSIZE_FOR_UNINTERRUPTABLE)
+        gc_collect_for_allocation();
+    else if (MAX_MARK_PAUSE > 0)
+        gc_mark_incrementally();
+    pthread_mutex_unlock(&sweep_lock);
+}
+
+
+/**
+ * Perform a minor collection if the nursery has been exhausted, and a
+ * compaction if one has been requested. This is called by the interpreter at
+ * points where its state is stored in the frames.
+ */
+void gc_safepoint() {
+    if (!gc_collection_pending || (uninterruptable_counter > 0))
+        return;
+    gc_collection_pending = false;
+    if (nursery_top != nursery_start)
+        gc_collect_minor();
+    // objects in the heap are only moved once the nursery is empty
+    if (compaction_pending)
+        gc_compact();
+}
+
+
+void gc_request_compaction() {
+    compaction_pending = true;
+    gc_collection_pending = true;
+}
+
+
+/**
+ * A compaction marks the live objects, and slides them to the start of the
+ * heap in three passes over the mark bitmap: the forward addresses are
+ * assigned in address order, all references are updated, and the objects
+ * are moved. Afterwards, the free space is a single allocation region.
+ */
+void gc_compact() {
+    pthread_mutex_lock(&sweep_lock);
+    compaction_pending = false;
+    num_collections++;
+    num_compactions++;
+    init_collect_stat();
+    int64_t start_time = gc_microseconds();
+    
+    // a pending sweep or marking is superseded, the free space is computed
+    // anew
+    gc_abort_incremental_marking();
+    memset(mark_bitmap, 0, mark_bitmap_words * sizeof(uintptr_t));
+    sweep_word = mark_bitmap_words;
+    sweep_pending = false;
+    gc_clear_free_lists();
+    alloc_pointer = alloc_limit = NULL;
+    
+    gc_mark_reachable_objects();
+    if (max_mark_depth > max_mark_depth_total)
+        max_mark_depth_total = max_mark_depth;
+    gc_prune_remembered_set();
+    gc_release_external_storage();
+    VMClass_flush_lookup_cache();
+    
+    int64_t mark_end = gc_microseconds();
+    mark_time = mark_end - start_time;
+    mark_time_total += mark_time;
+    if(gc_verbosity > 1)
+        collect_stat();
+    
+    compaction_top = object_space;
+    gc_visit_marked_objects(gc_set_forward_address);
+    
+    gc_visit_marked_objects(gc_update_references);
+    Universe_walk_globals(gc_forward);
+    gc_walk_boot_roots(gc_forward);
+    Interpreter_set_frame((pVMFrame)gc_forward((pVMObject)Interpreter_get_frame()));
+    for (size_t i = 0; i < remembered_set.size; i++)
+        remembered_set.elements[i] = gc_forward(remembered_set.elements[i]);
+    for (size_t i = 0; i < objects_with_external_storage.size; i++)
+        objects_with_external_storage.elements[i] =
+            gc_forward(objects_with_external_storage.elements[i]);
+    
+    gc_visit_marked_objects(gc_move_object);
+    memset(mark_bitmap, 0, mark_bitmap_words * sizeof(uintptr_t));
+    
+    // a heap grown beyond its maximum size gives the chunks back that the
+    // live objects no longer need
+    bool shrunk = false;
+    while (   (OBJECT_SPACE_SIZE > MAX_OBJECT_SPACE_SIZE)
+           && (   (intptr_t)compaction_top - (intptr_t)object_space
+               <= OBJECT_SPACE_SIZE - INITIAL_OBJECT_SPACE_SIZE)) {
+        OBJECT_SPACE_SIZE -= INITIAL_OBJECT_SPACE_SIZE;
+        gc_discard_space((void*)((intptr_t)object_space + OBJECT_SPACE_SIZE),
+                         INITIAL_OBJECT_SPACE_SIZE);
+        num_heap_shrunk++;
+        shrunk = true;
+    }
+    if (shrunk) {
+        mark_bitmap_words = OBJECT_SPACE_SIZE / sizeof(void*) / BITS_PER_WORD;
+        sweep_word = mark_bitmap_words;
+        BUFFERSIZE_FOR_UNINTERRUPTABLE = (intptr_t) (OBJECT_SPACE_SIZE * 0.1);
+        if(gc_verbosity > 1)
+            heap_size_stat("shrunk");
+    }
+    
+    // the space behind the live objects is the new allocation region
+    void* heap_end = (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE);
+    size_t free_space = (intptr_t)heap_end - (intptr_t)compaction_top;
+    memset(compaction_top, 0, free_space);
+    size_of_free_heap = free_space;
+    num_objects_in_heap = num_live;
+    if (free_space >= sizeof(struct _free_list_entry)) {
+        alloc_pointer = compaction_top;
+        alloc_limit = heap_end;
+    }
+    
+    last_collection_end = gc_microseconds();
+    compact_time = last_collection_end - mark_end;
+    compact_time_total += compact_time;
+    if(gc_verbosity > 1)
+        compact_stat();
+    
+    reset_alloc_stat();
+    pthread_mutex_unlock(&sweep_lock);
+}
 
 
-/*
- * if this counter equals 0, only then it is safe to collect the
- * garbage. The counter is increased during initializations of
- * VMObjects and the generation of classes
+/**
+ * Call visit for each object marked in the mark bitmap, in address order.
  */
-int uninterruptable_counter = 0;
-
-
-size_t size_of_free_heap = 0;
+void gc_visit_marked_objects(void (*visit)(pVMObject)) {
+    for (size_t word = 0; word < mark_bitmap_words; word++) {
+        uintptr_t bits = mark_bitmap[word];
+        while (bits != 0) {
+            size_t index = word * BITS_PER_WORD + COUNT_TRAILING_ZEROS(bits);
+            visit((pVMObject)((intptr_t)object_space + index * sizeof(void*)));
+            bits &= bits - 1;
+        }
+    }
+}
 
 
-//
-// values for GC statistics
-//
+void gc_set_forward_address(pVMObject object) {
+    object->gc_field = (intptr_t)compaction_top | (object->gc_field & GC_BITS);
+    compaction_top = (void*)((intptr_t)compaction_top + object->object_size);
+}
 
 
-uint32_t num_collections; // the number of collections performed
-uint32_t num_live;        // number of live objects (per collection)
-uint32_t spc_live;        // space consumed by live objects (per collection)
-uint32_t num_freed;       // number of freed objects (per collection)
-uint32_t spc_freed;       // freed space (per collection)
-uint32_t num_alloc;       // number of allocated objects (since last collection)
-uint32_t spc_alloc;       // allocated space (since last collection)
+void gc_update_references(pVMObject object) {
+    SEND(object, walk_references, gc_forward);
+}
 
 
-//
-// forward declarations
-//
+void gc_move_object(pVMObject object) {
+    pVMObject destination = FORWARD_ADDRESS(object);
+    // objects only move towards the start of the heap, and may overlap
+    memmove(destination, object, object->object_size);
+    destination->gc_field &= GC_BITS;
+}
 
 
-void gc_merge_free_spaces(void);
-void gc_initialize(void);
+/**
+ * Return the forward address of an object in the heap, all other references
+ * stay as they are. Only live objects are referenced while compacting.
+ */
+pVMObject gc_forward(pVMObject object) {
+    if (   IS_IMMEDIATE(object)
+        || ((void*)object < object_space)
+        || ((void*)object >= (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE)))
+        return object;
+    return FORWARD_ADDRESS(object);
+}
 
 
-void init_stat(void);
-void init_collect_stat(void);
-void collect_stat(void);
-void reset_alloc_stat(void);
+/**
+ * Objects of a size class are taken from its free_list if possible, all
+ * others are bump-allocated from the allocation region. Only when it is
+ * exhausted, the largest free chunk is taken as the next region, sweeping
+ * as far as needed to find one. The remainder of a region must either be
+ * empty or large enough to be turned into a free_list_entry again.
+ * Free space is zeroed by the collector, so allocated memory is not
+ * cleared here.
+ */
+void* gc_allocate(size_t size) { 
+    if(size == 0) return NULL;
+    
+    if(size < sizeof(struct _free_list_entry)) {
+        return internal_allocate(size);
+    }
+    
+    // start garbage collection if the free heap has less
+    // than BUFFERSIZE_FOR_UNINTERRUPTABLE Bytes once it has been swept
+    // and this allocation is interruptable
+    if (uninterruptable_counter <= 0) {
+        if (   !IS_SWEEPING()
+            && (size_of_free_heap <= BUFFERSIZE_FOR_UNINTERRUPTABLE))
+            gc_collect_for_allocation();
+        else if (MAX_MARK_PAUSE > 0)
+            gc_mark_incrementally();
+    }
+    
+    // while the background sweeper may add to the free_lists, they are only
+    // used with the lock held; without it, the allocation region serves the
+    // request
+    bool locked = false;
+    bool region_only = false;
+    if (IS_SWEEPING()) {
+        size_t available = (intptr_t)alloc_limit - (intptr_t)alloc_pointer;
+        if (   (   (size <= LARGEST_SIZE_CLASS)
+                && (__atomic_load_n(&size_class_free_lists[SIZE_CLASS(size)],
+                                    __ATOMIC_RELAXED) != NULL))
+            || !(   (size == available)
+                 || (size + sizeof(struct _free_list_entry) <= available))) {
+            pthread_mutex_lock(&sweep_lock);
+            locked = true;
+            // a sweep the background sweeper has finished is completed here
+            if (!HAS_UNSWEPT_CHUNKS())
+                gc_complete_sweep();
+        } else
+            region_only = true;
+    }
+    
+    void* result;
+    if (   !region_only
+        && (size <= LARGEST_SIZE_CLASS)
+        && (size_class_free_lists[SIZE_CLASS(size)] != NULL)) {
+        // exact fit
+        free_list_entry* entry = size_class_free_lists[SIZE_CLASS(size)];
+        size_class_free_lists[SIZE_CLASS(size)] = entry->next;
+        memset(entry, 0, sizeof(struct _free_list_entry));
+        result = entry;
+    } else {
+        size_t available = (intptr_t)alloc_limit - (intptr_t)alloc_pointer;
+        if (!(   (size == available)
+              || (size + sizeof(struct _free_list_entry) <= available))) {
+            // a sweep this starts is finished before it returns
+            pthread_mutex_lock(&sweep_lock);
+            gc_take_allocation_region(size);
+            pthread_mutex_unlock(&sweep_lock);
+        }
+        result = alloc_pointer;
+        alloc_pointer = (void*)((intptr_t)alloc_pointer + size);
+    }
+    
+    // update the available size
+    __atomic_sub_fetch(&size_of_free_heap, size, __ATOMIC_RELAXED);
+    if (gc_marking_incrementally)
+        allocated_since_slice += size;
+    if (locked)
+        pthread_mutex_unlock(&sweep_lock);
+    return result;
+}
 
 
-//
-// implementations
-//
+/**
+ * Add the zeroed chunk at start to the free_list for its size.
+ */
+void gc_add_free_entry(void* start, size_t size) {
+    free_list_entry* entry = (free_list_entry*) start;
+    free_list_entry** list = size <= LARGEST_SIZE_CLASS
+        ? &size_class_free_lists[SIZE_CLASS(size)]
+        : &large_free_list;
+    entry->size = size;
+    entry->next = *list;
+    // allocations peek at the size class lists without sweep_lock
+    __atomic_store_n(list, entry, __ATOMIC_RELAXED);
+}
 
 
-void gc_set_heap_size(uint32_t heap_size) {
-    // this can only be done before the heap is initialised - afterwards, it
-    // yields an error message and terminates the VM
-    if (object_space != NULL) {
-        Universe_error_exit("attempt to change heap size after initialisation");
-    }
-    OBJECT_SPACE_SIZE = 1024 * 1024 * heap_size;
+void gc_clear_free_lists() {
+    memset(size_class_free_lists, 0, sizeof(size_class_free_lists));
+    large_free_list = NULL;
 }
 
 
-void gc_mark_reachable_objects() {
-    // get globals
-    pHashmap globals = (pHashmap) Universe_get_globals_dictionary();
-    pHashmapElem elem = NULL;
-    
-    // iterate over the globals to mark all of them
-    for(size_t i = 0; i < globals->size; i++) {
-        elem = (pHashmapElem) globals->elems[i];
-        if (elem != NULL) {
-            gc_mark_object(elem->key);
-            gc_mark_object(elem->value);
-        }
-    }
-        
-    // Get the current frame and mark it.
-    // Since marking is done recursively, this automatically
-    // marks the whole stack
-    pVMFrame current_frame = (pVMFrame) Interpreter_get_frame();
-    if (current_frame != NULL) {
-        gc_mark_object(current_frame);
+/**
+ * Return the unused part of the allocation region to the free_lists.
+ */
+void gc_release_allocation_region() {
+    if (alloc_pointer != alloc_limit) {
+        gc_add_free_entry(alloc_pointer,
+            (intptr_t)alloc_limit - (intptr_t)alloc_pointer);
     }
+    alloc_pointer = alloc_limit = NULL;
 }
 
 
 /**
- *  check whether the object is inside the managed heap
- *  if it isn't, there is no VMObject to mark, otherwise
- *  check whether the object is already marked.
- *  if the self is an unmarked object inside the heap, then
- *  it is told to 'mark_references', recursively using this
- *  function for all its references.
- */
-void gc_mark_object(void* _self) {
-    pVMObject self = (pVMObject) _self;
-    if (   ((void*) self >= (void*)  object_space) 
-        && ((void*) self <= (void*) ((intptr_t) object_space + OBJECT_SPACE_SIZE)))
-    {
-        if (self->gc_field != 1) {
-            // mark self before recursively marking contained references
-            self->gc_field = 1;
-            num_live++;
-            spc_live += self->object_size;
-            SEND(self, mark_references);
+ * Make the largest free chunk the allocation region, which has to hold an
+ * object of the given size. If the free space is too fragmented for that,
+ * everything unreachable is collected, and if it still does not fit, the
+ * heap grows beyond its maximum size and is compacted at the next safepoint.
+ */
+void gc_take_allocation_region(size_t size) {
+    if (gc_find_allocation_region(size))
+        return;
+    
+    if (uninterruptable_counter <= 0) {
+        // an incremental marking in progress only finds what was
+        // unreachable when it started
+        if (gc_marking_incrementally) {
+            gc_collect();
+            gc_finish_sweep();
         }
+        gc_collect_for_allocation();
+        gc_finish_sweep();
+        if (gc_find_allocation_region(size))
+            return;
+    }
+    
+    if (!gc_grow_heap(size, true) || !gc_find_allocation_region(size)) {
+        // no space was left
+        // running the GC here will most certainly result in data loss!
+        fprintf(stderr,"Not enough heap! Data loss is possible\n");
+        fprintf(stderr, "FREE-Size: %zd, uninterruptable_counter: %d\n",
+            size_of_free_heap, uninterruptable_counter);
+        
+        exit(ERR_FAIL);
     }
+    gc_request_compaction();
 }
 
 
 /**
- * For debugging - the layout of the heap is shown.
- * This function uses 
- * - '[size]' for free space,
- * - '-xx-' for marked objects, and
- * - '-size-' for unmarked objects.
- * The output is also aligned to improve readability.
+ * Make the largest free chunk the allocation region, sweeping and growing
+ * the heap up to its maximum size as far as needed for an object of the
+ * given size. Return whether one was found.
  */
-void gc_show_memory() {
-    pVMObject pointer = object_space;
-    free_list_entry* current_entry = first_free_entry;
-    intptr_t object_size = 0;
-    intptr_t object_aligner = 0;
-    int line_count = 2;
+bool gc_find_allocation_region(size_t size) {
+    gc_release_allocation_region();
     
-    fprintf(stderr,"\n########\n# SHOW #\n########\n1 ");
+    #define REGION_FITS(ENTRY) \
+        (   ((ENTRY)->size == size) \
+         || ((ENTRY)->size >= size + sizeof(struct _free_list_entry)))
     
-    do {
-        while (((void*)pointer > (void*)current_entry->next) && (current_entry->next != NULL)) {
-            current_entry = current_entry->next;
-        }
-        
-        if ((   (void*)current_entry->next == (void*)pointer) 
-            || ((void*)current_entry == (void*)pointer)) 
-        {
-            if ((void*)current_entry == (void*)pointer) {
-                object_size = current_entry->size;
-            } else {
-                free_list_entry* next = current_entry->next;
-                object_size = next->size;
+    free_list_entry* largest;
+    free_list_entry** largest_link;
+    while (true) {
+        // find the largest entry
+        largest = NULL;
+        largest_link = NULL;
+        for (free_list_entry** link = &large_free_list; *link != NULL;
+             link = &(*link)->next) {
+            if (largest == NULL || (*link)->size > largest->size) {
+                largest = *link;
+                largest_link = link;
             }
-            fprintf(stderr, "[%ld]", object_size);
-        } else {
-            pVMObject object = (pVMObject) pointer;
-            
-            object_size = SEND(object, object_size);
-            
-            // is this object marked or not?
-            if (object->gc_field == 1) {
-                fprintf(stderr,"-xx-");
-            } else {
-                pVMSymbol class_name = SEND(SEND(object, get_class), get_name);
-                fprintf(stderr,"|%ld %s %p", object_size, SEND(class_name, get_plain_string), object);
+        }
+        // only small chunks are left
+        for (size_t i = NUMBER_OF_SIZE_CLASSES - 1;
+             largest == NULL && i > 0; i--) {
+            if (size_class_free_lists[i] != NULL) {
+                largest = size_class_free_lists[i];
+                largest_link = &size_class_free_lists[i];
             }
         }
-        // aligns the output by inserting a line break after 36 objects
-        object_aligner++;
-        if (object_aligner == 36) {
-            fprintf(stderr,"\n%d ", line_count++);
-            object_aligner = 0;
+        
+        if ((largest != NULL) && REGION_FITS(largest))
+            break;
+        if (IS_SWEEPING()) {
+            // more free chunks may be found by sweeping
+            gc_sweep_step();
+        } else if (!gc_grow_heap(size, false)) {
+            return false;
         }
-        pointer = (void*)((intptr_t)pointer + object_size);
-    } while ((void*)pointer < (void*)((intptr_t) object_space + OBJECT_SPACE_SIZE));
-}
-
-
-void gc_collect() {
-    num_collections++;
-    init_collect_stat();
-    
-    if(gc_verbosity > 2) {
-        fprintf(stderr, "-- pre-collection heap dump --\n");
-        gc_show_memory();
     }
     
-    gc_mark_reachable_objects();
-    //gc_show_memory();
-    pVMObject pointer = object_space;
-    free_list_entry* current_entry = first_free_entry;
-    size_t object_size = 0;
-
-    do {
-        // we need to find the last free entry before the pointer
-        // whose 'next' lies behind or is the pointer
-        while (((void*)pointer > (void*)current_entry->next) && (current_entry->next != NULL)) {
-            current_entry = current_entry->next;
-        }
-        
-        if (((void*)current_entry->next == (void*)pointer) || ((void*)current_entry == (void*)pointer)) {
-            // in case the pointer is the part of the free_list:
-            if ((void*)current_entry == (void*)pointer) {
-                object_size = current_entry->size;
-            } else {
-                free_list_entry* next = current_entry->next;
-                object_size = next->size;
-            }
-            //fprintf(stderr,"[%d]",object_size);
-            // nothing else to be done here
-        } else {
-            // in this case the pointer is a VMObject
-            pVMObject object = (pVMObject) pointer;         
-            object_size = SEND(object, object_size);
-            
-            // is this object marked or not?
-            if (object->gc_field == 1) {
-                // remove the marking
-                object->gc_field = 0;
-            } else {
-                num_freed++;
-                spc_freed += object_size;
-                
-                // add new entry containing this object to the free_list
-                SEND(object, free);
-                memset(object, 0, object_size);
-                free_list_entry* new_entry = (free_list_entry*) pointer;
-                new_entry->size = object_size;
-
-                // if the new entry lies before the first entry,
-                // adjust the pointer to the first one
-                if (new_entry < first_free_entry) {
-                    new_entry->next = first_free_entry;
-                    first_free_entry = new_entry;
-                    current_entry = new_entry;
-                } else {
-                    // insert the newly created entry right after the current entry
-                    new_entry->next = current_entry->next;
-                    current_entry->next = new_entry;
-                }
-            }
-        }
-        // set the pointer to the next object in the heap
-        pointer = (void*)((intptr_t)pointer + object_size);
-
-    } while ((void*)pointer < (void*)((intptr_t)object_space + OBJECT_SPACE_SIZE));
-
-    // combine free_entries, which are next to each other
-    gc_merge_free_spaces();
+    #undef REGION_FITS
     
-    if(gc_verbosity > 1)
-        collect_stat();
-    if(gc_verbosity > 2) {
-        fprintf(stderr, "-- post-collection heap dump --\n");
-        gc_show_memory();
-    }
+    // remove the entry from its free_list
+    *largest_link = largest->next;
     
-    reset_alloc_stat();
+    alloc_pointer = largest;
+    alloc_limit = (void*)((intptr_t)largest + largest->size);
+    // only the entry itself is not zeroed
+    memset(largest, 0, sizeof(struct _free_list_entry));
+    return true;
 }
 
 
-void* gc_allocate(size_t size) { 
-    if(size == 0) return NULL;
-    
-    if(size < sizeof(struct _free_list_entry)) {
-        return internal_allocate(size);
-    }
-    
-    // start garbage collection if the free heap has less
-    // than BUFFERSIZE_FOR_UNINTERRUPTABLE Bytes and this
-    // allocation is interruptable
-    if ((size_of_free_heap <= BUFFERSIZE_FOR_UNINTERRUPTABLE)
-        && (uninterruptable_counter <= 0)) {
-        gc_collect();
-    }
-    void* result = NULL;
-    
-    // initialize variables to search through the free_list
-    free_list_entry* entry = first_free_entry;
-    free_list_entry* before_entry = NULL;
-
-    // don't look for the perfect match, but for the first-fit
-    while (! ((entry->size == size) 
-               || (entry->next == NULL) 
-               || (entry->size >= (size + sizeof(struct _free_list_entry))))) { 
-        before_entry = entry;
-        entry = entry->next;
-    }
-    
-    // did we find a perfect fit?
-    // if so, we simply remove this entry from the list
-    if (entry->size == size) {
-        if (entry == first_free_entry) { 
-            // first one fitted - adjust the 'first-entry' pointer
-            first_free_entry = entry->next;
-        } else {
-            // simply remove the reference to the found entry
-            before_entry->next = entry->next;
-        } // entry fitted
-        result = entry;
-        
-    } else {
-        // did we find an entry big enough for the request and a new
-        // free_entry?
-        if (entry->size >= (size + sizeof(struct _free_list_entry))) {
-            // save data from found entry
-            size_t old_entry_size = entry->size;
-            free_list_entry* old_next = entry->next;
-            
-            result = entry;
-            // create new entry and assign data
-            free_list_entry* replace_entry =  (free_list_entry*) ((intptr_t)entry + size);
-            
-            replace_entry->size = old_entry_size - size;
-            replace_entry->next = old_next;
-            if (entry == first_free_entry) {
-                first_free_entry = replace_entry;
-            } else {
-                before_entry->next = replace_entry;
-            }
-        } else {
-            // no space was left
-            // running the GC here will most certainly result in data loss!
-            fprintf(stderr,"Not enough heap! Data loss is possible\n");
-            fprintf(stderr, "FREE-Size: %zd, uninterruptable_counter: %d\n",
-                size_of_free_heap, uninterruptable_counter);
-            
-            exit(ERR_FAIL);
-        }
-    }
-           
-    if(!result) {
-        fprintf(stderr, "Failed to allocate %ld bytes. Panic.\n", size);
+/**
+ * Bump-allocate zeroed memory in the boot space.
+ */
+void* gc_allocate_boot_object(size_t size) {
+    if (boot_space_size + size > BOOT_SPACE_SIZE) {
+        fprintf(stderr, "Not enough boot space for %zd bytes. Panic.\n", size);
         Universe_exit(-1);
     }
-    memset(result, 0, size);
-    
-    // update the available size
-    size_of_free_heap -= size;
+    void* result = (void*)((intptr_t)boot_space + boot_space_size);
+    boot_space_size += size;
     return result;
 }
 
 
 void* gc_allocate_object(size_t size) {
     size_t aligned_size = size + PAD_BYTES(size);
-    void* o = gc_allocate(aligned_size);
+    void* o;
+    if (boot_allocation) {
+        o = gc_allocate_boot_object(aligned_size);
+    } else if ((nursery_size == 0) || (pretenured_counter > 0)) {
+        o = gc_allocate(aligned_size);
+        num_objects_in_heap++;
+        // objects allocated while marking incrementally are initialised
+        // without write barrier
+        if (gc_marking_incrementally)
+            gc_mark_dirty(o);
+    } else if ((intptr_t)nursery_top + aligned_size
+               <= (intptr_t)nursery_start + nursery_size) {
+        // nursery memory is zeroed by the minor collections
+        o = nursery_top;
+        nursery_top = (void*)((intptr_t)nursery_top + aligned_size);
+    } else {
+        // the nursery is full until the next safepoint. Until then, new
+        // objects are allocated in the heap and remembered, since they will
+        // be initialised with young references.
+        gc_collection_pending = true;
+        o = gc_allocate(aligned_size);
+        num_objects_in_heap++;
+        gc_remember(o);
+        if (gc_marking_incrementally)
+            gc_mark_dirty(o);
+    }
     if(o)
         ((pOOObject)o)->object_size = aligned_size;
     num_alloc++;
@@ -428,47 +2076,17 @@ void* gc_allocate_object(size_t size) {
  * However, it is called upon by all VMObjects.
  */
 void gc_free(void* ptr) {
-    // do nothing when called for an object inside the object_space
-    if ((   ptr < (void*)  object_space) 
-        || (ptr >= (void*) ((intptr_t)object_space + OBJECT_SPACE_SIZE))) 
+    // do nothing when called for an object inside the object_space, the
+    // nursery or the boot space
+    if (   ((   ptr < (void*)  object_space) 
+            || (ptr >= (void*) ((intptr_t)object_space + OBJECT_SPACE_SIZE)))
+        && !IS_YOUNG(ptr) && !IS_BOOT_OBJECT(ptr))
     {
         internal_free(ptr);
     }
 }
 
 
-// free entries which are next to each other are merged into one entry
-void gc_merge_free_spaces() {
-    free_list_entry* entry = first_free_entry;
-    free_list_entry* entry_to_append = NULL;
-    size_t new_size = 0;
-    free_list_entry* new_next = NULL;
-    
-    size_of_free_heap = 0;
-
-    while (entry->next != NULL) {
-        if (((intptr_t)entry + (intptr_t)(entry->size)) == (intptr_t)(entry->next)) {
-            entry_to_append = entry->next;
-            new_size = entry->size + entry_to_append->size;
-            new_next = entry_to_append->next;
-            
-            memset(entry_to_append, 0, entry_to_append->size);
-            entry->next = new_next;
-            entry->size = new_size;
-        } else {
-            size_of_free_heap += entry->size;   
-            entry = entry->next;
-        }
-    }
-    if (entry->next == NULL) {
-        size_of_free_heap += entry->size;   
-    } else {
-        fprintf(stderr, "Missed last free_entry of GC\n");
-        Universe_exit(-1);
-    }
-}
-
-
 void* internal_allocate(size_t size) {
     if(size == 0)
         return NULL;
@@ -487,37 +2105,111 @@ void internal_free(void* ptr) {
 }
 
 
+void object_stack_push(object_stack* stack, pVMObject object) {
+    if (stack->size == stack->capacity) {
+        stack->capacity = stack->capacity ? 2 * stack->capacity : 256;
+        stack->elements = (pVMObject*)realloc(stack->elements,
+            stack->capacity * sizeof(pVMObject));
+        if (!stack->elements) {
+            debug_error("Failed to grow an object stack. Panic.\n");
+            Universe_exit(-1);
+        }
+    }
+    stack->elements[stack->size++] = object;
+}
+
+
+void object_stack_free(object_stack* stack) {
+    free(stack->elements);
+    memset(stack, 0, sizeof(object_stack));
+}
+
+
 /**
  * Sets up the heap and the free_list managing the free entries
  * inside the heap.
  */
 void gc_initialize() { 
+    OBJECT_SPACE_SIZE = INITIAL_OBJECT_SPACE_SIZE;
+    if (MAX_OBJECT_SPACE_SIZE < OBJECT_SPACE_SIZE)
+        MAX_OBJECT_SPACE_SIZE = OBJECT_SPACE_SIZE;
+    RESERVED_OBJECT_SPACE_SIZE = 2 * MAX_OBJECT_SPACE_SIZE;
+    
     // Buffersize is adjusted to the size of the heap (10%)
     BUFFERSIZE_FOR_UNINTERRUPTABLE = (intptr_t) (OBJECT_SPACE_SIZE * 0.1);
 
-    // allocation of the heap
-    object_space = malloc(OBJECT_SPACE_SIZE);
+    // allocation of the heap, which is zeroed
+    object_space = gc_reserve_space(RESERVED_OBJECT_SPACE_SIZE);
     if (!object_space) {
-        fprintf(stderr, "Failed to allocate the initial %ld bytes for the GC. Panic.\n",
-                OBJECT_SPACE_SIZE);
+        fprintf(stderr, "Failed to reserve %ld bytes for the GC. Panic.\n",
+                RESERVED_OBJECT_SPACE_SIZE);
         Universe_exit(-1);
     } 
-    memset(object_space, 0, OBJECT_SPACE_SIZE);
     size_of_free_heap = OBJECT_SPACE_SIZE;
+    num_objects_in_heap = 0;
+    low_occupancy_collections = 0;
+    
+    // the mark bitmap covers the reserved space
+    mark_bitmap_words = OBJECT_SPACE_SIZE / sizeof(void*) / BITS_PER_WORD;
+    sweep_word = mark_bitmap_words;
+    mark_bitmap = (uintptr_t*)internal_allocate(
+        RESERVED_OBJECT_SPACE_SIZE / sizeof(void*) / BITS_PER_WORD
+        * sizeof(uintptr_t));
     
-    // initialize free_list by creating the first
+    // initialize the free_lists by creating the first
     // entry, which contains the whole object_space
-    first_free_entry = (free_list_entry*) object_space;
-    first_free_entry->size = OBJECT_SPACE_SIZE;
-    first_free_entry->next = NULL;
+    gc_clear_free_lists();
+    gc_add_free_entry(object_space, OBJECT_SPACE_SIZE);
+    alloc_pointer = alloc_limit = NULL;
+    
+    // allocation of the nursery
+    if (NURSERY_SIZE > 0) {
+        nursery_start = internal_allocate(NURSERY_SIZE);
+        nursery_size = NURSERY_SIZE;
+    }
+    nursery_top = nursery_start;
+    
+    // reservation of the boot space, which is zeroed as well
+    boot_space = gc_reserve_space(BOOT_SPACE_SIZE);
+    if (!boot_space) {
+        fprintf(stderr, "Failed to reserve %d bytes for the boot space. Panic.\n",
+                BOOT_SPACE_SIZE);
+        Universe_exit(-1);
+    }
+    boot_space_size = 0;
+    boot_allocation = false;
+    gc_collection_pending = false;
+    compaction_pending = false;
+    gc_marking_incrementally = false;
+    
+    gc_start_mark_threads();
+    sweep_pending = false;
+    gc_start_sweeper();
     
     // initialise statistical counters
     init_stat();
+    last_collection_end = gc_microseconds();
 }
 
 void gc_finalize() {
-    free(object_space);
+    gc_stop_sweeper();
+    gc_release_space(object_space, RESERVED_OBJECT_SPACE_SIZE);
     object_space = NULL;
+    alloc_pointer = alloc_limit = NULL;
+    
+    internal_free(nursery_start);
+    nursery_start = nursery_top = NULL;
+    nursery_size = 0;
+    object_stack_free(&remembered_set);
+    object_stack_free(&promoted_objects);
+    gc_release_space(boot_space, BOOT_SPACE_SIZE);
+    boot_space = NULL;
+    object_stack_free(&boot_roots);
+    gc_stop_mark_threads();
+    object_stack_free(&objects_with_external_storage);
+    object_stack_free(&dirty_objects);
+    internal_free(mark_bitmap);
+    mark_bitmap = NULL;
 }
 
 
@@ -542,6 +2234,30 @@ void gc_end_uninterruptable_allocation() {
 }
 
 
+/**
+ * while this counter is gt zero, objects are allocated in the heap instead
+ * of the nursery.
+ */
+void gc_start_pretenured_allocation() {
+    pretenured_counter++;
+}
+
+
+void gc_end_pretenured_allocation() {
+    pretenured_counter--;
+}
+
+
+void gc_start_boot_allocation() {
+    boot_allocation = true;
+}
+
+
+void gc_end_boot_allocation() {
+    boot_allocation = false;
+}
+
+
 //
 // functions for GC statistics and debugging output
 //
@@ -552,6 +2268,18 @@ void gc_end_uninterruptable_allocation() {
  */
 void init_stat(void) {
     num_collections = 0;
+    num_minor_collections = 0;
+    spc_promoted_total = 0;
+    max_mark_depth_total = 0;
+    mark_time_total = 0;
+    sweep_time_total = 0;
+    num_heap_grown = 0;
+    num_heap_shrunk = 0;
+    num_compactions = 0;
+    compact_time_total = 0;
+    num_mark_slices = 0;
+    max_mark_pause = 0;
+    num_boot_roots = 0;
 
     // these two need to be initially set here, as they have to be preserved
     // across collections and cannot be reset in init_collect_stat()
@@ -568,8 +2296,10 @@ void init_collect_stat(void) {
     // the collection in reset_alloc_stat()
     num_live = 0;
     spc_live = 0;
-    num_freed = 0;
-    spc_freed = 0;
+    max_mark_depth = 0;
+    mark_time = 0;
+    sweep_time = 0;
+    interpreter_sweep_time = 0;
 }
 
 
@@ -592,9 +2322,32 @@ void reset_alloc_stat(void) {
  */
 void gc_stat(void) {
     fprintf(stderr, "-- GC statistics --\n");
-    fprintf(stderr, "* heap size %ld B (%ld kB, %.2f MB)\n",
-        OBJECT_SPACE_SIZE, _KB(OBJECT_SPACE_SIZE), _MB(OBJECT_SPACE_SIZE));
+    fprintf(stderr, "* heap size %ld B (%ld kB, %.2f MB), maximum %.2f MB\n",
+        OBJECT_SPACE_SIZE, _KB(OBJECT_SPACE_SIZE), _MB(OBJECT_SPACE_SIZE),
+        _MB(MAX_OBJECT_SPACE_SIZE));
+    fprintf(stderr, "* heap has grown %d times and shrunk %d times\n",
+        num_heap_grown, num_heap_shrunk);
+    fprintf(stderr, "* boot space %zu B (%zu kB), %d objects of it are roots\n",
+        boot_space_size, _KB(boot_space_size), num_boot_roots);
     fprintf(stderr, "* performed %d collections\n", num_collections);
+    fprintf(stderr, "* maximum mark stack depth %d\n", max_mark_depth_total);
+    if (MARK_THREADS > 1)
+        fprintf(stderr, "* marked on %ld threads\n", MARK_THREADS);
+    if (MAX_MARK_PAUSE > 0)
+        fprintf(stderr, "* marked incrementally in %d slices, longest pause "
+            "%lld us (target %ld us)\n", num_mark_slices,
+            (long long)max_mark_pause, MAX_MARK_PAUSE);
+    fprintf(stderr, "* spent %lld us marking and %lld us sweeping\n",
+        (long long)mark_time_total, (long long)sweep_time_total);
+    fprintf(stderr, "* performed %d compactions, moving objects in %lld us\n",
+        num_compactions, (long long)compact_time_total);
+    if (NURSERY_SIZE > 0) {
+        fprintf(stderr, "* nursery size %ld B (%ld kB)\n",
+            NURSERY_SIZE, _KB(NURSERY_SIZE));
+        fprintf(stderr, "* performed %d minor collections, promoting %llu kB\n",
+            num_minor_collections,
+            (unsigned long long)_KB(spc_promoted_total));
+    }
 }
 
 
@@ -602,8 +2355,43 @@ void gc_stat(void) {
  * output per-collection statistics
  */
 void collect_stat(void) {
-    fprintf(stderr, "\n[GC %d, %d alloc (%d kB), %d live (%d kB), %d freed "\
-        "(%d kB)]\n",
+    fprintf(stderr, "\n[GC %d, %d alloc (%d kB), %d live (%d kB), "\
+        "mark stack depth %d, marked in %lld us]\n",
         num_collections, num_alloc, _KB(spc_alloc), num_live, _KB(spc_live),
-        num_freed, _KB(spc_freed));
+        max_mark_depth, (long long)mark_time);
+}
+
+
+/*
+ * output per-collection statistics once the heap has been swept
+ */
+void sweep_stat(void) {
+    fprintf(stderr, "\n[sweep %d, %d freed (%d kB), swept in %lld us]\n",
+        num_collections, num_freed, _KB(spc_freed), (long long)sweep_time);
+}
+
+
+/*
+ * output per-compaction statistics
+ */
+void compact_stat(void) {
+    fprintf(stderr, "\n[compaction %d, %zu kB free, compacted in %lld us]\n",
+        num_compactions, _KB(size_of_free_heap), (long long)compact_time);
+}
+
+
+/*
+ * output per-minor-collection statistics
+ */
+void collect_minor_stat(void) {
+    fprintf(stderr, "\n[minor GC %d, %d promoted (%d kB)]\n",
+        num_minor_collections, num_promoted, _KB(spc_promoted));
+}
+
+
+/*
+ * output a change of the heap size
+ */
+void heap_size_stat(const char* change) {
+    fprintf(stderr, "\n[heap %s to %ld kB]\n", change, _KB(OBJECT_SPACE_SIZE));
 }
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include <compiler/GenerationContexts.h>
 
 #include <stdlib.h>
+#include <stdbool.h>
 
 
 /*
@@ -46,12 +47,141 @@ THE SOFTWARE.
 void gc_set_heap_size(uint32_t heap_size);
 
 
-void gc_mark_object(void* _self);
+/*
+ * The heap grows in chunks of its initial size, up to a maximum size in MB
+ * that can be set on VM startup. How it grows and shrinks depends on the
+ * percentage of time the collector may take compared to the program.
+ */
+void gc_set_max_heap_size(uint32_t max_heap_size);
+void gc_set_gc_time_ratio(uint32_t gc_time_ratio);
+
+
+/*
+ * The marking can be spread over a number of threads, which can be set on VM
+ * startup. The interpreter is stopped while they mark.
+ */
+void gc_set_mark_threads(uint32_t mark_threads);
+
+
+/*
+ * With a target maximum pause in ms set on VM startup, the heap is marked
+ * incrementally, in slices interleaved with the interpreter.
+ */
+void gc_set_max_pause(uint32_t max_pause);
+
+
+/*
+ * Objects are allocated in a nursery, from which the survivors are promoted
+ * into the heap by minor collections. Its size can be set on VM startup in
+ * kB; a size of 0 disables the nursery.
+ */
+void gc_set_nursery_size(uint32_t nursery_size);
+
+
+/*
+ * bits of the gc_field of objects in the heap
+ */
+#define GC_MARKED     1
+#define GC_REMEMBERED 2
+#define GC_DIRTY      4
+// objects in the boot space never move, so this bit cannot collide with a
+// forward address
+#define GC_BOOT_ROOT  8
+
+
+extern void*  nursery_start;
+extern size_t nursery_size;
+extern bool   gc_collection_pending;
+extern bool   gc_marking_incrementally;
+extern void*  boot_space;
+extern size_t boot_space_size;
+
+
+#define IS_YOUNG(O) \
+    (   !IS_IMMEDIATE(O) \
+     && ((uintptr_t)(O) - (uintptr_t)nursery_start) < nursery_size)
+
+#define IS_BOOT_OBJECT(O) \
+    (   !IS_IMMEDIATE(O) \
+     && ((uintptr_t)(O) - (uintptr_t)boot_space) < boot_space_size)
+
+
+pVMObject gc_mark_object(pVMObject self);
+void gc_remember(void* object);
+void gc_shade(pVMObject object);
+void gc_mark_dirty(void* object);
+void gc_add_boot_root(void* object);
+
+
+/*
+ * Dead objects are not visited by the sweep. Objects in the heap that own
+ * memory outside of it must be registered to be sent free when they die.
+ * Objects in the boot space never die, but become roots instead, since that
+ * memory may refer to other objects without write barrier.
+ */
+void gc_register_external_storage(void* object);
+
+
+/*
+ * The write barrier has to be passed every store of a reference into an
+ * object: an object in the heap that gets a reference to a young one is put
+ * into the remembered set, which is a root set of minor collections, and an
+ * object in the boot space that gets a reference to one outside of it
+ * becomes a root of all collections. While the heap is marked
+ * incrementally, the stored object is shaded grey, so that no marked object
+ * refers to an unmarked one.
+ */
+static inline void gc_write_barrier(void* holder, pVMObject value) {
+    if (   IS_YOUNG(value) && !IS_YOUNG(holder)
+        && !(((pOOObject)holder)->gc_field & GC_REMEMBERED))
+        gc_remember(holder);
+    if (   IS_BOOT_OBJECT(holder) && (value != NULL) && !IS_BOOT_OBJECT(value)
+        && !IS_IMMEDIATE(value)
+        && !(((pOOObject)holder)->gc_field & GC_BOOT_ROOT))
+        gc_add_boot_root(holder);
+    if (gc_marking_incrementally)
+        gc_shade(value);
+}
+
+
+/*
+ * Remember an object in the heap which is written to without barrier, like
+ * the stack of the frame the interpreter is executing. While the heap is
+ * marked incrementally, the object is also scanned again to finish marking.
+ */
+static inline void gc_remember_if_old(void* object) {
+    if (   nursery_size != 0 && !IS_YOUNG(object)
+        && !(((pOOObject)object)->gc_field & GC_REMEMBERED))
+        gc_remember(object);
+    if (   gc_marking_incrementally && !IS_YOUNG(object)
+        && !(((pOOObject)object)->gc_field & GC_DIRTY))
+        gc_mark_dirty(object);
+}
 
 
 void gc_collect(void);
+void gc_safepoint(void);
+
+
+/*
+ * Request a compacting collection, which moves all live objects to the start
+ * of the heap. Since it moves objects, it is performed at the next safepoint.
+ */
+void gc_request_compaction(void);
+
 void gc_start_uninterruptable_allocation(void);
 void gc_end_uninterruptable_allocation(void);
+void gc_start_pretenured_allocation(void);
+void gc_end_pretenured_allocation(void);
+
+
+/*
+ * The objects created while the VM boots, like the core classes, their
+ * methods and symbols, are allocated in the boot space, which is neither
+ * marked nor swept. Once the boot has ended, it is never allocated in again.
+ */
+void gc_start_boot_allocation(void);
+void gc_end_boot_allocation(void);
 
 
 void*  gc_allocate(size_t size);
@@ -60,5 +60,15 @@ void  _Class_fields(pVMObject object, pVMFrame frame) {
 void  _Class_methods(pVMObject object, pVMFrame frame) {
   pVMClass self = (pVMClass)SEND(frame, pop);
   pVMArray methods = (pVMArray)SEND(self, get_instance_invokables);
+  // drop the spare slots that appending invokables leaves at the end
+  int64_t count = SEND(self, get_number_of_instance_invokables);
+  if(count < SEND(methods, get_number_of_indexable_fields)) {
+      methods = Universe_new_array(count);
+      for(int64_t i = 0; i < count; i++) {
+          pVMObject invokable = SEND(self, get_instance_invokable, i);
+          SEND(methods, set_indexable_field, i, invokable);
+      }
+      SEND(self, set_instance_invokables, methods);
+  }
   SEND(frame, push, (pVMObject)methods);
 }
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include <vmobjects/VMFrame.h>
 #include <vmobjects/VMClass.h>
 #include <vmobjects/VMInvokable.h>
+#include <vmobjects/VMInteger.h>
 
 #include <vm/Universe.h>
 
@@ -45,13 +46,19 @@ void  _Object_equalequal(pVMObject object, pVMFrame frame) {
 
 void  _Object_objectSize(pVMObject object, pVMFrame frame) {
     pVMObject self = SEND(frame, pop);
-    SEND(frame, push, (pVMObject)Universe_new_integer(self->object_size));
+    intptr_t size = SEND(self, object_size);
+    SEND(frame, push, (pVMObject)Universe_new_integer(size));
 }
 
 
 void  _Object_hashcode(pVMObject object, pVMFrame frame) {
     pVMObject self = SEND(frame, pop);
-    SEND(frame, push, (pVMObject)Universe_new_integer(self->hash));
+    // a SmallInteger hashes to its value, as a boxed Integer does, and
+    // other immediates to their encoding
+    int64_t hash = IS_SMALL_INTEGER(self) ? SMALL_INTEGER_VALUE(self)
+                 : IS_IMMEDIATE(self)     ? (intptr_t)self
+                                          : self->hash;
+    SEND(frame, push, (pVMObject)Universe_new_integer(hash));
 }
 
 void  _Object_inspect(pVMObject object, pVMFrame frame) {
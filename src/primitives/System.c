@@ -127,7 +127,8 @@ void  _System_ticks(pVMObject object, pVMFrame frame) {
 
 void _System_fullGC(pVMObject object, pVMFrame frame) {
     SEND(frame, pop);
-    gc_collect();
+    // the frame must stay in place until the primitive has returned
+    gc_request_compaction();
     SEND(frame, push, true_object);
 }
 
@@ -168,7 +168,9 @@ void Shell_start() {
         // Start the Interpreter
         Interpreter_start();
         
-        // Save the result of the run method
+        // Save the result of the run method, from the bootstrap frame, which
+        // may have been moved
+        current_frame = Interpreter_get_frame();
         it = SEND(current_frame, pop);
         internal_free(statement);
     }
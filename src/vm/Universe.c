@@ -187,11 +187,20 @@ static void print_usage_and_exit(const char* executable) {
     fprintf(stderr, "        set search path for application classes\n");
     fprintf(stderr, "    -d  enable disassembling (twice for tracing)\n");
     fprintf(stderr, "    -g  enable garbage collection details:\n" \
-                    "        1x - print statistics when VM shuts down\n" \
+                    "        1x - print statistics (including inline cache " \
+                    "hits and misses) when VM shuts down\n" \
                     "        2x - print statistics upon each collection\n" \
                     "        3x - print statistics and dump heap upon each " \
                     "collection\n");
-    fprintf(stderr, "    -Hx set the heap size to x MB (default: 1 MB)\n");
+    fprintf(stderr, "    -Hx set the initial heap size to x MB (default: 1 MB)\n");
+    fprintf(stderr, "    -Mx set the maximum heap size to x MB (default: 64 MB)\n");
+    fprintf(stderr, "    -Rx grow the heap when collecting takes more than " \
+                    "x%% of the time (default: 5%%)\n");
+    fprintf(stderr, "    -Px mark the heap on x threads in parallel (default: 1)\n");
+    fprintf(stderr, "    -Ix mark the heap incrementally, in pauses of at most " \
+                    "x ms (default: 0, marking stops the program)\n");
+    fprintf(stderr, "    -Nx set the nursery size to x kB (default: 256 kB, " \
+                    "0 disables it)\n");
     fprintf(stderr, "    -h  show this help\n");
     // exit
     Universe_exit(ERR_SUCCESS);
@@ -202,8 +211,10 @@ static void print_usage_and_exit(const char* executable) {
 #pragma mark Extern Callable Functions
 
 void Universe_exit(int err) {
-    if(gc_verbosity > 0)
+    if(gc_verbosity > 0) {
         gc_stat();
+        Interpreter_stat();
+    }
     Universe_destruct();
     exit(err);
 }
@@ -247,6 +258,21 @@ const char** Universe_handle_arguments(
         } else if(argv[i][0] == '-' && argv[i][1] == 'H') {
             int heap_size = atoi(argv[i] + 2);
             gc_set_heap_size(heap_size);
+        } else if(argv[i][0] == '-' && argv[i][1] == 'M') {
+            int max_heap_size = atoi(argv[i] + 2);
+            gc_set_max_heap_size(max_heap_size);
+        } else if(argv[i][0] == '-' && argv[i][1] == 'R') {
+            int gc_time_ratio = atoi(argv[i] + 2);
+            gc_set_gc_time_ratio(gc_time_ratio);
+        } else if(argv[i][0] == '-' && argv[i][1] == 'P') {
+            int mark_threads = atoi(argv[i] + 2);
+            gc_set_mark_threads(mark_threads);
+        } else if(argv[i][0] == '-' && argv[i][1] == 'I') {
+            int max_pause = atoi(argv[i] + 2);
+            gc_set_max_pause(max_pause);
+        } else if(argv[i][0] == '-' && argv[i][1] == 'N') {
+            int nursery_size = atoi(argv[i] + 2);
+            gc_set_nursery_size(nursery_size);
         } else if((strcmp(argv[i], "-h") == 0) ||
             (strcmp(argv[i], "--help") == 0)
         ) {
@@ -293,6 +319,9 @@ static pVMObject initialize_object_system() {
      * affected file globals: globals_dictionary
      */
     VMClass_init_primitive_map();
+    // register the VTables shared by the immediates
+    VMInteger_vtable();
+    VMDouble_vtable();
 
     // setup the Hashmap for all globals
     globals_dictionary = Hashmap_new();
@@ -397,8 +426,13 @@ static pVMMethod create_bootstrap_method() {
 
 pVMObject Universe_interpret(const char* class_name, const char* method_name) {
     gc_initialize();
+    // the bootstrap frame is referred to after the interpreter has finished,
+    // so it must not be moved by minor collections
+    gc_start_pretenured_allocation();
+    gc_start_boot_allocation();
     initialize_object_system();
     pVMMethod bootstrap_method = create_bootstrap_method();
+    gc_end_boot_allocation();
 
     // lookup the class and method
     pVMClass class = Universe_load_class(Universe_symbol_for_cstr(class_name));
@@ -414,22 +448,33 @@ pVMObject Universe_interpret(const char* class_name, const char* method_name) {
 
     // invoke the method on the class object
     TSEND(VMInvokable, method, invoke, bootstrap_frame);
+    gc_end_pretenured_allocation();
 
     // start the interpreter
     Interpreter_start();
 
+    // the bootstrap frame may have been moved by a compaction, it is the
+    // current frame again once the interpreter has halted
+    bootstrap_frame = Interpreter_get_frame();
     return SEND(bootstrap_frame, pop);
 }
 
 
 void Universe_start(int argc, const char** argv) {
     gc_initialize();
+    // the objects created before the interpreter starts are kept alive
+    // by the VM anyway
+    gc_start_pretenured_allocation();
+    // the core classes, their methods and symbols live as long as the VM
+    gc_start_boot_allocation();
     pVMObject system_object = initialize_object_system();
     pVMMethod bootstrap_method = create_bootstrap_method();
+    gc_end_boot_allocation();
 
     // start the shell if no filename is given
     if(argc == 0) {
       Shell_set_bootstrap_method(bootstrap_method);
+      gc_end_pretenured_allocation();
       Shell_start();
       return;
     }
@@ -457,6 +502,7 @@ void Universe_start(int argc, const char** argv) {
 
     // reset "-d" indicator
     if(!(trace>0)) dump_bytecodes = 2 - trace;
+    gc_end_pretenured_allocation();
     
     // start the interpreter
     Interpreter_start();
@@ -628,6 +674,10 @@ pVMObject Universe_new_instance(pVMClass instance_class) {
 
 
 pVMInteger Universe_new_integer(int64_t value) {
+    // Integers in the SmallInteger range are immediates
+    if(FITS_SMALL_INTEGER(value))
+        return (pVMInteger)SMALL_INTEGER_FOR(value);
+    
     // Allocate a new integer and set its class to be the integer class
     pVMInteger result = VMInteger_new_with(value);
     SEND((pVMObject)result, set_class, integer_class);
@@ -638,6 +688,11 @@ pVMInteger Universe_new_integer(int64_t value) {
 
 
 pVMDouble Universe_new_double(double value) {
+    // Doubles that fit the SmallFloat encoding are immediates
+    uint64_t payload;
+    if(small_float_encodable(value, &payload))
+        return (pVMDouble)SMALL_FLOAT_FOR(payload);
+    
     // Allocate a new integer and set its class to be the double class
     pVMDouble result = VMDouble_new_with(value);
     SEND((pVMObject)result, set_class, double_class);
@@ -690,7 +745,10 @@ pVMString Universe_new_string_concat(pVMString a, pVMString b) {
 
 pVMSymbol Universe_new_symbol(pString string) {
     // Allocate a new symbol and set its class to be the symbol class
+    // symbols are referred to by the symbol table
+    gc_start_pretenured_allocation();
     pVMSymbol result = VMSymbol_new(string);
+    gc_end_pretenured_allocation();
     SEND((pVMObject)result, set_class, symbol_class);
     
     // Insert the new symbol into the symbol table
@@ -758,26 +816,95 @@ pHashmap Universe_get_globals_dictionary() {
 }
 
 
+/**
+ * Visit all references the VM keeps to objects: the dictionary of globals,
+ * the symbol table and the special objects, classes and symbols. The
+ * references are replaced by the result of walk, so that the collector can
+ * move the objects.
+ */
+void Universe_walk_globals(walk_heap_fn walk) {
+    for(size_t i = 0; i < globals_dictionary->size; i++) {
+        pHashmapElem elem = globals_dictionary->elems[i];
+        if(elem != NULL) {
+            elem->key = walk((pVMObject)elem->key);
+            elem->value = walk((pVMObject)elem->value);
+        }
+    }
+    Symbol_table_walk(walk);
+    
+    #define WALK(GLOBAL) GLOBAL = (void*)walk((pVMObject)GLOBAL)
+    WALK(nil_object);
+    WALK(true_object);
+    WALK(false_object);
+    
+    WALK(object_class);
+    WALK(class_class);
+    WALK(metaclass_class);
+    WALK(nil_class);
+    WALK(integer_class);
+    WALK(array_class);
+    WALK(method_class);
+    WALK(symbol_class);
+    WALK(primitive_class);
+    WALK(string_class);
+    WALK(system_class);
+    WALK(block_class);
+    WALK(double_class);
+    WALK(true_class);
+    WALK(false_class);
+    
+    WALK(doesNotUnderstand_sym);
+    WALK(unknownGlobal_sym);
+    WALK(escapedBlock_sym);
+    WALK(run_sym);
+    #undef WALK
+}
+
+
 pVMObject Universe_get_global(pVMSymbol name) {
     // Return the global with the given name if it's in the dictionary of
-    // globals
-    if(Universe_has_global(name))
-        return (pVMObject)SEND(globals_dictionary, get, name);
+    // globals and bound to a value
+    pVMArray binding = (pVMArray)SEND(globals_dictionary, get, name);
+    if(binding)
+        return GLOBAL_BINDING_VALUE(binding);
     
     // Global not found
     return NULL;
 }
 
 
+pVMArray Universe_get_global_binding(pVMSymbol name) {
+    // Return the binding cell of the global with the given name, creating an
+    // unbound one if there is none yet
+    pVMArray binding = (pVMArray)SEND(globals_dictionary, get, name);
+    if(!binding) {
+        // neither the name nor a value to be stored are rooted yet
+        // binding cells are referred to by the globals dictionary
+        gc_start_uninterruptable_allocation();
+        gc_start_pretenured_allocation();
+        binding = Universe_new_array(2);
+        gc_end_pretenured_allocation();
+        gc_end_uninterruptable_allocation();
+        GLOBAL_BINDING_NAME(binding) = (pVMObject)name;
+        GLOBAL_BINDING_VALUE(binding) = NULL;
+        SEND(globals_dictionary, put, name, binding);
+    }
+    return binding;
+}
+
+
 void Universe_set_global(pVMSymbol name, pVMObject value) {
-    // Insert the given value into the dictionary of globals
-    SEND(globals_dictionary, put, name, value);
+    // Store the given value in the binding cell of the global, so that all
+    // methods referring to it see the new value
+    pVMArray binding = Universe_get_global_binding(name);
+    gc_write_barrier(binding, value);
+    GLOBAL_BINDING_VALUE(binding) = value;
 }
 
 
 bool Universe_has_global(pVMSymbol name) {
     // Returns if the Universe has a value for the global of the given name
-    return SEND(globals_dictionary, contains_key, name);
+    return Universe_get_global(name) != NULL;
 }
 
 
@@ -799,11 +926,13 @@ pVMClass Universe_get_block_class_with_args(int64_t number_of_arguments) {
         return (pVMClass)Universe_get_global(name);
 
     // Get the block class for blocks with the given number of arguments
+    gc_start_pretenured_allocation();
     pVMClass result = Universe_load_class_basic(name, NULL);
     
     // Add the appropriate value primitive to the block class
     SEND(result, add_instance_primitive,
          VMBlock_get_evaluation_primitive(number_of_arguments), true);
+    gc_end_pretenured_allocation();
     
     // Insert the block class into the dictionary of globals
     Universe_set_global(name, (pVMObject)result);
@@ -818,17 +947,20 @@ pVMClass Universe_load_class(pVMSymbol name) {
     if (Universe_has_global(name)) 
         return (pVMClass)Universe_get_global(name);
     
-    // Load the class
+    // Load the class; classes and their methods live as long as the VM
+    gc_start_pretenured_allocation();
     pVMClass result = Universe_load_class_basic(name, NULL);
         
     // we fail silently, it is not fatal that loading a class failed
     if (!result) {
+        gc_end_pretenured_allocation();
 		return (pVMClass) nil_object;
     }
 
     // Load primitives (if necessary) and return the resulting class
     if (SEND(result, has_primitives) || SEND(result->class, has_primitives)) 
         SEND(result, load_primitives, class_path, cp_count);
+    gc_end_pretenured_allocation();
 
     // Insert the class into the dictionary of globals
     Universe_set_global(name, (pVMObject)result);
@@ -883,7 +1015,9 @@ pVMClass Universe_load_class_basic(pVMSymbol name, pVMClass system_class) {
 
 pVMClass Universe_load_shell_class(const char* stmt) {
     // Load the class from a stream and return the loaded class
+    gc_start_pretenured_allocation();
     pVMClass result = SourcecodeCompiler_compile_class_string(stmt, NULL);
+    gc_end_pretenured_allocation();
     if(dump_bytecodes)
         Disassembler_dump(result);
     return result;    
@@ -106,10 +106,20 @@ pVMClass      Universe_new_system_class(void);
 void          Universe_initialize_system_class(pVMClass, pVMClass, const char*);
 
 pHashmap      Universe_get_globals_dictionary(void);
+void          Universe_walk_globals(walk_heap_fn);
 pVMObject     Universe_get_global(pVMSymbol);
+pVMArray      Universe_get_global_binding(pVMSymbol);
 void          Universe_set_global(pVMSymbol, pVMObject);
 bool          Universe_has_global(pVMSymbol);
 
+/*
+ * The dictionary of globals maps names to binding cells, which methods
+ * reference directly. A cell is a two-element array holding the name and the
+ * value of the global; the value is NULL as long as the global is unbound.
+ */
+#define GLOBAL_BINDING_NAME(binding)  ((binding)->fields[0])
+#define GLOBAL_BINDING_VALUE(binding) ((binding)->fields[1])
+
 pVMClass      Universe_get_block_class(void);
 pVMClass      Universe_get_block_class_with_args(int64_t);
 
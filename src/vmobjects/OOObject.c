@@ -32,6 +32,13 @@ THE SOFTWARE.
 #include "OOObject.h"
 
 
+/*
+ * The VTables of immediate objects, indexed by their tag bits.
+ * They are registered by the respective vtable functions.
+ */
+void* immediate_vtables[IMMEDIATE_TAG_MASK + 1];
+
+
 /*
  * Initialize an Object
  */
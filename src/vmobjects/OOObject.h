@@ -33,6 +33,32 @@ THE SOFTWARE.
 #include <misc/defs.h>
 
 
+#pragma mark **** Immediate Objects.  ******
+
+
+/**
+ * Object references with any of the low tag bits set are immediates: they
+ * carry their value in the reference itself and have no heap storage.
+ * Their behaviour is looked up in immediate_vtables, indexed by the tag.
+ * A set lowest bit marks a SmallInteger (see VMInteger.h).
+ */
+#define IMMEDIATE_TAG_MASK ((uintptr_t) 3)
+
+#define IS_IMMEDIATE(O) (((uintptr_t)(O) & IMMEDIATE_TAG_MASK) != 0)
+
+extern void* immediate_vtables[IMMEDIATE_TAG_MASK + 1];
+
+/**
+ * The VTable of an object reference, which may be an immediate.
+ * O is evaluated more than once.
+ */
+#define VTABLE_OF(O) \
+    (IS_IMMEDIATE(O) \
+        ? (typeof((O)->_vtable)) \
+            immediate_vtables[(uintptr_t)(O) & IMMEDIATE_TAG_MASK] \
+        : (O)->_vtable)
+
+
 #pragma mark **** Object Macros.  ******
 
 
@@ -42,7 +68,7 @@ THE SOFTWARE.
  */
 #define SEND(O,M,...) \
     ({ typeof(O) _O = (O); \
-    (_O->_vtable->M(_O , ##__VA_ARGS__)); \
+    (VTABLE_OF(_O)->M(_O , ##__VA_ARGS__)); \
     })
 
 
@@ -53,12 +79,12 @@ THE SOFTWARE.
 #ifdef EXPERIMENTAL
 #define TSEND(TRAIT,O,M,...) \
     ({ typeof(O) _O = (O); \
-    (((VTABLE(TRAIT)*)(_O->_vtable))->M((TRAIT *)_O , ##__VA_ARGS__)); \
+    (((VTABLE(TRAIT)*)VTABLE_OF(_O))->M((TRAIT *)_O , ##__VA_ARGS__)); \
     })
 #else
 #define TSEND(TRAIT,O,M,...) \
     ({ typeof(O) _O = (O); \
-    (((VTABLE(TRAIT)*)(_O->_vtable->_ttable))->M((TRAIT*)_O , ##__VA_ARGS__)); \
+    (((VTABLE(TRAIT)*)(VTABLE_OF(_O)->_ttable))->M((TRAIT*)_O , ##__VA_ARGS__)); \
     })
 #endif // EXPERIMENTAL
 
@@ -109,12 +135,15 @@ THE SOFTWARE.
 
 
 #define IS_A(object,class) \
-    (((class *)object)->_vtable == class##_vtable())
+    ({ class* _O = (class*)(object); \
+    (VTABLE_OF(_O) == class##_vtable()); \
+    })
 
 
 #ifdef EXPERIMENTAL
 #define SUPPORTS(O,TRAIT) ({ \
-    VTABLE(OOObject)* _vt = (VTABLE(OOObject)*)((O)->_vtable); \
+    typeof(O) _O = (O); \
+    VTABLE(OOObject)* _vt = (VTABLE(OOObject)*)VTABLE_OF(_O); \
     bool found = false; \
     while(_vt->_ttable) { \
         if(_vt->_ttable == TRAIT##_vtable()) \
@@ -125,8 +154,10 @@ THE SOFTWARE.
 })
 #else
 #define SUPPORTS(O,TRAIT) \
-    ((VTABLE(TRAIT)*)((VTABLE(OOObject)*)((O)->_vtable)->_ttable) == \
-        TRAIT##_vtable())
+    ({ typeof(O) _O = (O); \
+    ((VTABLE(TRAIT)*)((VTABLE(OOObject)*)VTABLE_OF(_O))->_ttable == \
+        TRAIT##_vtable()); \
+    })
 #endif // EXPERIMENTAL
 
 
@@ -45,6 +45,19 @@ void Symbol_table_insert(pVMSymbol symbol) {
 }
 
 
+/**
+ * The symbol table keeps the symbols alive; walk visits, and may replace,
+ * each of them.
+ */
+void Symbol_table_walk(walk_heap_fn walk) {
+    for(size_t i = 0; i < symtab->size; i++) {
+        pStringHashmapElem elem = (pStringHashmapElem)symtab->elems[i];
+        if(elem != NULL)
+            elem->value = walk((pVMObject)elem->value);
+    }
+}
+
+
 void Symbol_table_init(void) {
     symtab = StringHashmap_new();
 }
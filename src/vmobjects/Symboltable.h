@@ -31,6 +31,7 @@ THE SOFTWARE.
 
 pVMSymbol Symbol_table_lookup(pString restrict);
 void      Symbol_table_insert(pVMSymbol);
+void      Symbol_table_walk(walk_heap_fn);
 
 void      Symbol_table_init(void);
 void      Symbol_table_destruct(void);
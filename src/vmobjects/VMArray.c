@@ -128,6 +128,7 @@ void _VMArray_set_indexable_field(void* _self, int64_t index, pVMObject value) {
         Universe_error_exit(s);
     }
     // set the indexable field with the given index to the given value
+    gc_write_barrier(self, value);
     self->fields[index + SEND(self, _get_offset)] = value;
 }
 
@@ -164,13 +165,9 @@ void _VMArray_copy_indexable_fields_to(void* _self, pVMArray destination) {
 }
 
 
-void _VMArray_mark_references(void* _self) {
-    pVMArray self = (pVMArray)_self;
-	int64_t size_of_indexable_fields = SEND(self, get_number_of_indexable_fields);
-	for(int i=0;i<size_of_indexable_fields;i++) {
-		gc_mark_object(SEND(self, get_indexable_field, i));
-	}
-	SUPER(VMObject, self, mark_references);
+void _VMArray_walk_references(void* _self, walk_heap_fn walk) {
+    // the indexable fields are part of the fields
+	SUPER(VMObject, _self, walk_references, walk);
 }
 
 
@@ -199,8 +196,8 @@ VTABLE(VMArray)* VMArray_vtable(void) {
         _VMArray_vtable.copy_indexable_fields_to =
             METHOD(VMArray, copy_indexable_fields_to);
      
-		_VMArray_vtable.mark_references = 
-            METHOD(VMArray, mark_references);   
+		_VMArray_vtable.walk_references = 
+            METHOD(VMArray, walk_references);   
 
         VMArray_vtable_inited = true;
     }
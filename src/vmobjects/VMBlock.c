@@ -91,11 +91,9 @@ pVMFrame _VMBlock_get_context(void* _self) {
 }
 
 
-void _VMBlock_mark_references(void* _self) {
-    pVMBlock self = (pVMBlock) _self;
-    gc_mark_object(self->method);
-    gc_mark_object(self->context);
-    SUPER(VMObject, self, mark_references);
+void _VMBlock_walk_references(void* _self, walk_heap_fn walk) {
+    // method and context are fields
+    SUPER(VMObject, _self, walk_references, walk);
 }
 
 
@@ -116,8 +114,8 @@ VTABLE(VMBlock)* VMBlock_vtable(void) {
         _VMBlock_vtable.get_method  = METHOD(VMBlock, get_method);
         _VMBlock_vtable.get_context = METHOD(VMBlock, get_context);
         
-        _VMBlock_vtable.mark_references = 
-            METHOD(VMBlock, mark_references);
+        _VMBlock_vtable.walk_references = 
+            METHOD(VMBlock, walk_references);
         
         
         VMBlock_vtable_inited = true;
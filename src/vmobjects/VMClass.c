@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "VMSymbol.h"
 #include "VMArray.h"
 #include "VMPrimitive.h"
+#include "VMInteger.h"
 
 #include <memory/gc.h>
 
@@ -39,9 +40,12 @@ THE SOFTWARE.
 
 #include <vm/Universe.h>
 
+#include <interpreter/Interpreter.h>
+
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #ifdef CSOM_WIN
 /**
@@ -59,7 +63,54 @@ THE SOFTWARE.
 #endif
 
 // private
-int64_t number_of_super_instance_fields(void* _self);
+static void invokables_changed(void);
+static void rebuild_invokables_table(pVMClass self, int64_t count);
+static size_t find_invokables_table_slot(pVMArray table, pVMSymbol signature);
+static void put_into_invokables_table(pVMArray table, pVMObject invokable,
+                                      int64_t index);
+static void remove_from_invokables_table(pVMArray table, pVMSymbol signature,
+                                         int64_t index);
+static pVMObject lookup_invokable_in_table(pVMClass self, pVMSymbol signature);
+
+
+/*
+ * Global cache of method lookups, indexed by a hash of class and signature.
+ * Failed lookups are cached as well, with a NULL invokable. The entries do not
+ * keep their objects alive, so the cache is flushed upon each collection, and
+ * whenever a class' invokables change.
+ */
+#define LOOKUP_CACHE_SIZE 1024
+
+typedef struct _lookup_cache_entry {
+    pVMClass  class;
+    pVMSymbol signature;
+    pVMObject invokable;
+} lookup_cache_entry;
+
+static lookup_cache_entry lookup_cache[LOOKUP_CACHE_SIZE];
+
+
+/*
+ * Each class keeps its invokables in an open-addressed hash table besides the
+ * instance_invokables array, which remains what Class>>methods answers. The
+ * array may have spare slots at its end, so that invokables are appended in
+ * amortised constant time; Class>>methods drops them before answering the
+ * array. The number in use is kept in the first field of the table, as a
+ * SmallInteger. The other fields of the table form slots of a signature and
+ * the index of its invokable in the array. The capacity of the table is a
+ * power of two at least twice the number of invokables, and collisions are
+ * resolved by linear probing. Signatures are interned symbols, so they are
+ * compared by identity; they are hashed by their string, since the collector
+ * may move them. Empty slots hold nil.
+ */
+#define INVOKABLES_TABLE_SLOT(signature, mask) \
+    (((uintptr_t)((pOOObject)(signature))->hash) & (mask))
+
+#define INVOKABLES_TABLE_COUNT(table)           ((table)->fields[0])
+#define INVOKABLES_TABLE_SIGNATURE(table, slot) ((table)->fields[2 * (slot) + 1])
+#define INVOKABLES_TABLE_INDEX(table, slot)     ((table)->fields[2 * (slot) + 2])
+#define INVOKABLES_TABLE_CAPACITY(table) \
+    ((size_t)((table)->num_of_fields - 1) / 2)
 
 //
 //  Class Methods (Starting with VMClass_) 
@@ -70,7 +121,8 @@ int64_t number_of_super_instance_fields(void* _self);
  * Create a new VMClass
  */
 pVMClass VMClass_new(void) {
-    return VMClass_new_num_fields(SIZE_DIFF_VMOBJECT(VMClass) - 1);
+    // all members of a class are fields, which the collector walks
+    return VMClass_new_num_fields(SIZE_DIFF_VMOBJECT(VMClass));
 }
 
 
@@ -97,6 +149,18 @@ pVMClass VMClass_new_num_fields(intptr_t number_of_fields) {
 }
 
 
+void VMClass_flush_lookup_cache(void) {
+    memset(lookup_cache, 0, sizeof(lookup_cache));
+}
+
+
+static void invokables_changed(void) {
+    // cached lookups may now find a different invokable
+    VMClass_flush_lookup_cache();
+    Interpreter_invalidate_inline_caches();
+}
+
+
 pVMClass VMClass_assemble(class_generation_context* cgc) {
     // build class class name
     const char* cgc_name = SEND(cgc->name, get_rawChars);
@@ -166,6 +230,7 @@ void _VMClass_init(void* _self, ...) {
     va_start(args, _self);
     SUPER(VMObject, self, init, va_arg(args, intptr_t));
     va_end(args);
+    self->invokables_table = (pVMArray)nil_object;
 }
 
 
@@ -187,7 +252,9 @@ pVMClass _VMClass_get_super_class(void* _self) {
 void _VMClass_set_super_class(void* _self, pVMClass value) {
     pVMClass self = (pVMClass)_self;
     // set the super class
+    gc_write_barrier(self, (pVMObject)value);
     self->super_class = value;
+    invokables_changed();
 }
 
 
@@ -208,6 +275,7 @@ pVMSymbol _VMClass_get_name(void* _self) {
 void _VMClass_set_name(void* _self, pVMSymbol value) {
     pVMClass self = (pVMClass)_self;
     // set the name of this class by writing to the field with name index
+    gc_write_barrier(self, (pVMObject)value);
     self->name = value;
 }
 
@@ -222,6 +290,7 @@ pVMArray _VMClass_get_instance_fields(void* _self) {
 void _VMClass_set_instance_fields(void* _self, pVMArray value) {
     pVMClass self = (pVMClass)_self;
     // set the instance fields
+    gc_write_barrier(self, (pVMObject)value);
     self->instance_fields = value;
 }
 
@@ -236,7 +305,11 @@ pVMArray _VMClass_get_instance_invokables(void* _self) {
 void _VMClass_set_instance_invokables(void* _self, pVMArray value) {
     pVMClass self = (pVMClass)_self;
     // set the instance invokables 
+    gc_write_barrier(self, (pVMObject)value);
     self->instance_invokables = value;
+    rebuild_invokables_table(self,
+                             SEND(value, get_number_of_indexable_fields));
+    invokables_changed();
     
     // make sure this class is the holder of all invokables in the array
     for(int i = 0; i < SEND(self, get_number_of_instance_invokables); i++) {
@@ -249,16 +322,17 @@ void _VMClass_set_instance_invokables(void* _self, pVMArray value) {
 int64_t _VMClass_get_number_of_instance_invokables(void* _self) {
     pVMClass self = (pVMClass)_self;
     // return the number of instance invokables in this class
-    pVMArray arr = SEND(self, get_instance_invokables);
-    return SEND(arr, get_number_of_indexable_fields);
+    pVMArray table = self->invokables_table;
+    if((pVMObject)table == nil_object || table == NULL)
+        return 0;
+    return SMALL_INTEGER_VALUE(INVOKABLES_TABLE_COUNT(table));
 }
 
 
 pVMObject _VMClass_get_instance_invokable(void* _self, int64_t index) {
     pVMClass self = (pVMClass)_self;
     // get the instance invokable with the given index
-    pVMArray arr = SEND(self, get_instance_invokables);
-    return SEND(arr, get_indexable_field, index);
+    return SEND(self->instance_invokables, get_indexable_field, index);
 }
 
 
@@ -266,34 +340,150 @@ void _VMClass_set_instance_invokable(void* _self, int64_t idx, pVMObject value)
     pVMClass self = (pVMClass)_self;
     // set this class as the holder of the given invokable
     TSEND(VMInvokable, value,  set_holder, self);
+    pVMObject old_value = SEND(self, get_instance_invokable, idx);
+    pVMSymbol old_signature = TSEND(VMInvokable, old_value, get_signature);
     // set the instance method with the given index to the given value
-    pVMArray arr = SEND(self, get_instance_invokables);
-    SEND(arr, set_indexable_field, idx, value);
+    SEND(self->instance_invokables, set_indexable_field, idx, value);
+    // only a changed signature needs its slot of the table updated
+    pVMSymbol signature = TSEND(VMInvokable, value, get_signature);
+    if(signature != old_signature) {
+        remove_from_invokables_table(self->invokables_table, old_signature,
+                                     idx);
+        put_into_invokables_table(self->invokables_table, value, idx);
+    }
+    invokables_changed();
 }
 
 
-pVMObject _VMClass_lookup_invokable(void* _self, pVMSymbol signature) {
-    pVMClass self = (pVMClass)_self;
-    pVMObject invokable = NULL;
-    // lookup invokable with given signature in array of instance invokables
-    for(int i = 0; i < SEND(self, get_number_of_instance_invokables); i++) {
-      // get the next invokable in the instance invokable array
-      invokable = SEND(self, get_instance_invokable, i);
-      // return the invokable if the signature matches
-      if(TSEND(VMInvokable, invokable, get_signature) == signature)
-          return invokable;
-    }    
-    // traverse the super class chain by calling lookup on the super class
-    if(SEND(self, has_super_class)) {
-        invokable = SEND(self->super_class, lookup_invokable, signature);
-        if(invokable)
-            return invokable;
+/**
+ * Replace the table by one for the first count invokables of the array.
+ */
+static void rebuild_invokables_table(pVMClass self, int64_t count) {
+    size_t capacity = 4;
+    while(capacity < 2 * (size_t)count)
+        capacity <<= 1;
+
+    // self and its invokables are not necessarily reachable yet
+    gc_start_uninterruptable_allocation();
+    pVMArray table = Universe_new_array(2 * capacity + 1);
+    gc_end_uninterruptable_allocation();
+
+    INVOKABLES_TABLE_COUNT(table) = SMALL_INTEGER_FOR(count);
+    for(int64_t i = 0; i < count; i++)
+        put_into_invokables_table(table, SEND(self, get_instance_invokable, i),
+                                  i);
+    gc_write_barrier(self, (pVMObject)table);
+    self->invokables_table = table;
+}
+
+
+/**
+ * Return the slot of the table holding the given signature, or the free slot
+ * where it would be put.
+ */
+static size_t find_invokables_table_slot(pVMArray table, pVMSymbol signature) {
+    size_t mask = INVOKABLES_TABLE_CAPACITY(table) - 1;
+    size_t slot = INVOKABLES_TABLE_SLOT(signature, mask);
+    // the table is never full, so the probe ends at a free slot at the latest
+    while(INVOKABLES_TABLE_SIGNATURE(table, slot) != nil_object &&
+          INVOKABLES_TABLE_SIGNATURE(table, slot) != (pVMObject)signature)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+
+/**
+ * Put the invokable at the given index of the array into the table. Should
+ * its signature be in the table already, the first invokable wins, as it
+ * does when searching the array.
+ */
+static void put_into_invokables_table(pVMArray table, pVMObject invokable,
+                                      int64_t index) {
+    pVMSymbol signature = TSEND(VMInvokable, invokable, get_signature);
+    size_t slot = find_invokables_table_slot(table, signature);
+    if(INVOKABLES_TABLE_SIGNATURE(table, slot) == nil_object) {
+        gc_write_barrier(table, (pVMObject)signature);
+        INVOKABLES_TABLE_SIGNATURE(table, slot) = (pVMObject)signature;
+        INVOKABLES_TABLE_INDEX(table, slot) = SMALL_INTEGER_FOR(index);
+    }
+}
+
+
+/**
+ * Remove the signature from the table if it is there for the invokable at the
+ * given index. The following slots of its probe sequence are shifted back, so
+ * that no probe ends early at the freed slot.
+ */
+static void remove_from_invokables_table(pVMArray table, pVMSymbol signature,
+                                         int64_t index) {
+    size_t mask = INVOKABLES_TABLE_CAPACITY(table) - 1;
+    size_t slot = find_invokables_table_slot(table, signature);
+    if(INVOKABLES_TABLE_SIGNATURE(table, slot) == nil_object ||
+       SMALL_INTEGER_VALUE(INVOKABLES_TABLE_INDEX(table, slot)) != index)
+        return;
+    for(size_t next = (slot + 1) & mask;
+        INVOKABLES_TABLE_SIGNATURE(table, next) != nil_object;
+        next = (next + 1) & mask) {
+        size_t home = INVOKABLES_TABLE_SLOT(
+            INVOKABLES_TABLE_SIGNATURE(table, next), mask);
+        // an entry may fill the gap if its probe sequence passes the gap
+        if(((next - home) & mask) >= ((next - slot) & mask)) {
+            INVOKABLES_TABLE_SIGNATURE(table, slot) =
+                INVOKABLES_TABLE_SIGNATURE(table, next);
+            INVOKABLES_TABLE_INDEX(table, slot) =
+                INVOKABLES_TABLE_INDEX(table, next);
+            slot = next;
+        }
     }
+    INVOKABLES_TABLE_SIGNATURE(table, slot) = nil_object;
+    INVOKABLES_TABLE_INDEX(table, slot) = nil_object;
+}
+
+
+static pVMObject lookup_invokable_in_table(pVMClass self,
+                                           pVMSymbol signature) {
+    pVMArray table = self->invokables_table;
+    if((pVMObject)table == nil_object || table == NULL)
+        return NULL;
+    size_t slot = find_invokables_table_slot(table, signature);
+    if(INVOKABLES_TABLE_SIGNATURE(table, slot) == nil_object)
+        return NULL;
+    return self->instance_invokables->fields[
+        SMALL_INTEGER_VALUE(INVOKABLES_TABLE_INDEX(table, slot))];
+}
+
+
+static pVMObject lookup_invokable_in_hierarchy(pVMClass self,
+                                               pVMSymbol signature) {
+    // lookup invokable with given signature in the table of instance invokables
+    pVMObject invokable = lookup_invokable_in_table(self, signature);
+    if(invokable)
+        return invokable;
+    // traverse the super class chain
+    if(SEND(self, has_super_class))
+        return lookup_invokable_in_hierarchy(self->super_class, signature);
     // invokable not found
     return NULL;
 }
 
 
+pVMObject _VMClass_lookup_invokable(void* _self, pVMSymbol signature) {
+    pVMClass self = (pVMClass)_self;
+    // consult the global lookup cache first; it also remembers failed lookups
+    lookup_cache_entry* entry = &lookup_cache[
+        (((uintptr_t)self ^ (uintptr_t)signature) >> 3)
+        & (LOOKUP_CACHE_SIZE - 1)];
+    if(entry->class == self && entry->signature == signature)
+        return entry->invokable;
+
+    pVMObject invokable = lookup_invokable_in_hierarchy(self, signature);
+    entry->class = self;
+    entry->signature = signature;
+    entry->invokable = invokable;
+    return invokable;
+}
+
+
 int64_t _VMClass_lookup_field_index(void* _self, pVMSymbol field_name) {
     pVMClass self = (pVMClass)_self;
     // lookup field with given name in array of instance fields
@@ -309,20 +499,42 @@ int64_t _VMClass_lookup_field_index(void* _self, pVMSymbol field_name) {
 
 bool _VMClass_add_instance_invokable(void* _self, pVMObject value) {
     pVMClass self = (pVMClass)_self;
-    // add the given invokable to the array of instance invokables
-    for(int i = 0; i < SEND(self, get_number_of_instance_invokables); i++) {
-        // get the next invokable in the instance invokable array
-        pVMObject invokable = SEND(self, get_instance_invokable, i);
-        // replace the invokable with the given one if the signature matches
-        if(TSEND(VMInvokable, invokable, get_signature) 
-           == TSEND(VMInvokable, value, get_signature)) {
-            SEND(self, set_instance_invokable, i, value);
-            return false;
-        }
+    pVMSymbol signature = TSEND(VMInvokable, value, get_signature);
+    // a class without any invokables gets its array and table on the first add
+    if((pVMObject)self->invokables_table == nil_object ||
+       self->invokables_table == NULL)
+        SEND(self, set_instance_invokables, Universe_new_array(0));
+    pVMArray table = self->invokables_table;
+    size_t slot = find_invokables_table_slot(table, signature);
+    // replace the invokable with the given one if the signature matches
+    if(INVOKABLES_TABLE_SIGNATURE(table, slot) != nil_object) {
+        int64_t index = SMALL_INTEGER_VALUE(INVOKABLES_TABLE_INDEX(table, slot));
+        TSEND(VMInvokable, value, set_holder, self);
+        SEND(self->instance_invokables, set_indexable_field, index, value);
+        invokables_changed();
+        return false;
+    }
+    
+    // append the given invokable to the array of instance invokables, whose
+    // size is doubled if it has no spare slot left
+    int64_t count = SEND(self, get_number_of_instance_invokables);
+    if(count == SEND(self->instance_invokables, get_number_of_indexable_fields)) {
+        pVMArray invokables = Universe_new_array(count < 2 ? 4 : 2 * count);
+        SEND(self->instance_invokables, copy_indexable_fields_to, invokables);
+        gc_write_barrier(self, (pVMObject)invokables);
+        self->instance_invokables = invokables;
+    }
+    TSEND(VMInvokable, value, set_holder, self);
+    SEND(self->instance_invokables, set_indexable_field, count, value);
+    
+    // the table grows once it would be more than half full
+    if(2 * (size_t)(count + 1) > INVOKABLES_TABLE_CAPACITY(table))
+        rebuild_invokables_table(self, count + 1);
+    else {
+        put_into_invokables_table(table, value, count);
+        INVOKABLES_TABLE_COUNT(table) = SMALL_INTEGER_FOR(count + 1);
     }
-    // append the given method to the array of instance methods
-    self->instance_invokables = 
-        SEND(self->instance_invokables, copy_and_extend_with, value);
+    invokables_changed();
     return true;
 }
 
@@ -340,26 +552,17 @@ void _VMClass_add_instance_primitive(void* _self, pVMPrimitive value, bool warn)
 
 pVMSymbol _VMClass_get_instance_field_name(void* _self, int64_t index) {
     pVMClass self = (pVMClass)_self;
-    // get the name of the instance field with the given index
-    if(index >= number_of_super_instance_fields(self)) {
-        // adjust the index to account for fields defined in the super class
-        index -= number_of_super_instance_fields(self);
-        // return the symbol representing the instance fields name
-        return 
-            (pVMSymbol)SEND(self->instance_fields, get_indexable_field, index);
-    } else {
-        // ask the super class to return the name of the instance field
-        return SEND(self->super_class, get_instance_field_name, index);
-    }
+    // get the name of the instance field with the given index; the instance
+    // fields already start with the fields defined in the super classes
+    return (pVMSymbol)SEND(self->instance_fields, get_indexable_field, index);
 }
 
 
 int64_t _VMClass_get_number_of_instance_fields(void* _self) {
     pVMClass self = (pVMClass)_self;
-    // get the total number of instance fields in this class
-    return
-        SEND(self->instance_fields, get_number_of_indexable_fields) +
-        number_of_super_instance_fields(self);
+    // get the total number of instance fields in this class, including the
+    // ones defined in the super classes
+    return SEND(self->instance_fields, get_number_of_indexable_fields);
 }
 
 
@@ -376,18 +579,6 @@ bool _VMClass_has_primitives(void* _self) {
 }
 
 
-int64_t number_of_super_instance_fields(void* _self) {
-    pVMClass self = (pVMClass)_self;
-    /*
-     * get the total number of instance fields defined in super classes
-     */
-    if(SEND(self, has_super_class))
-        return SEND(self->super_class, get_number_of_instance_fields);
-    else
-        return 0;
-}
-
-
 #pragma mark primitive loading helpers
 
 
@@ -630,13 +821,10 @@ void _VMClass_load_primitives(void* _self, const pString* cp, size_t cp_count) {
 }
 
 
-void _VMClass_mark_references(void* _self) {
-    pVMClass self = (pVMClass) _self;
-    gc_mark_object(self->super_class);
-    gc_mark_object(self->name);
-    gc_mark_object(self->instance_fields);
-    gc_mark_object(self->instance_invokables);
-    SUPER(VMObject, self, mark_references);
+void _VMClass_walk_references(void* _self, walk_heap_fn walk) {
+    // super class, name, instance fields, invokables and the invokables
+    // table are fields
+    SUPER(VMObject, _self, walk_references, walk);
 }
 
 
@@ -684,8 +872,8 @@ VTABLE(VMClass)* VMClass_vtable(void) {
     _VMClass_vtable.has_primitives    = METHOD(VMClass, has_primitives);
     _VMClass_vtable.load_primitives   = METHOD(VMClass, load_primitives);
     
-    _VMClass_vtable.mark_references = 
-        METHOD(VMClass, mark_references);
+    _VMClass_vtable.walk_references = 
+        METHOD(VMClass, walk_references);
 
     VMClass_vtable_inited = true;
     
@@ -75,7 +75,8 @@ VTABLE(VMClass) {
     pVMClass  super_class; \
     pVMSymbol name; \
     pVMArray  instance_fields; \
-    pVMArray  instance_invokables
+    pVMArray  instance_invokables; \
+    pVMArray  invokables_table
 
 
 struct _VMClass {
@@ -94,6 +95,7 @@ pVMClass VMClass_assemble(class_generation_context*);
 void     VMClass_assemble_system_class(class_generation_context*, pVMClass);
 
 void     VMClass_init_primitive_map(void);
+void     VMClass_flush_lookup_cache(void);
 
 #pragma mark vtable initialization
 
@@ -25,9 +25,12 @@ THE SOFTWARE.
   */
 
 #include "VMDouble.h"
+#include "VMClass.h"
 
 #include <memory/gc.h>
 
+#include <vm/Universe.h>
+
 //
 //  Class Methods (Starting with VMDouble_) 
 //
@@ -78,15 +81,72 @@ void _VMDouble_init(void* _self, ...) {
 //
 //  Instance Methods (Starting with _VMDouble_) 
 //
+//  All of them are also sent to SmallFloats, which have no heap storage.
 //
 double _VMDouble_get_embedded_double(void* _self) {
+    if(IS_SMALL_FLOAT(_self))
+        return small_float_value(_self);
     pVMDouble self = (pVMDouble)_self;
     return self->embedded_double;
 }
 
-void _VMDouble_mark_references(void* _self) {
+
+intptr_t _VMDouble_object_size(void* _self) {
+    if(IS_SMALL_FLOAT(_self))
+        return 0;
+    return SUPER(VMObject, _self, object_size);
+}
+
+
+pVMClass _VMDouble_get_class(void* _self) {
+    if(IS_SMALL_FLOAT(_self))
+        return double_class;
+    return SUPER(VMObject, _self, get_class);
+}
+
+
+void _VMDouble_set_class(void* _self, pVMClass value) {
+    // SmallFloats are always instances of the double class
+    if(!IS_SMALL_FLOAT(_self))
+        SUPER(VMObject, _self, set_class, value);
+}
+
+
+pVMSymbol _VMDouble_get_field_name(void* _self, int64_t index) {
+    return SEND(double_class, get_instance_field_name, index);
+}
+
+
+int64_t _VMDouble_get_field_index(void* _self, pVMSymbol name) {
+    return SEND(double_class, lookup_field_index, name);
+}
+
+
+intptr_t _VMDouble_get_number_of_fields(void* _self) {
+    if(IS_SMALL_FLOAT(_self))
+        return 0;
+    return SUPER(VMObject, _self, get_number_of_fields);
+}
+
+
+pVMObject _VMDouble_get_field(void* _self, int64_t index) {
+    if(IS_SMALL_FLOAT(_self))
+        return nil_object;
+    return SUPER(VMObject, _self, get_field, index);
+}
+
+
+void _VMDouble_set_field(void* _self, int64_t index, pVMObject value) {
+    if(!IS_SMALL_FLOAT(_self))
+        SUPER(VMObject, _self, set_field, index, value);
+}
+
+
+void _VMDouble_walk_references(void* _self, walk_heap_fn walk) {
+    if(IS_SMALL_FLOAT(_self))
+        return;
     pVMDouble self = (pVMDouble) _self;
-    SUPER(VMObject, self, mark_references);
+    SUPER(VMObject, self, walk_references, walk);
 }
 
 
@@ -101,11 +161,25 @@ VTABLE(VMDouble)* VMDouble_vtable(void) {
     if(! VMDouble_vtable_inited) {
         *((VTABLE(VMObject)*)&_VMDouble_vtable) = *VMObject_vtable();
         _VMDouble_vtable.init                = METHOD(VMDouble, init);
+        _VMDouble_vtable.object_size         = METHOD(VMDouble, object_size);
+        _VMDouble_vtable.get_class           = METHOD(VMDouble, get_class);
+        _VMDouble_vtable.set_class           = METHOD(VMDouble, set_class);
+        _VMDouble_vtable.get_field_name      =
+            METHOD(VMDouble, get_field_name);
+        _VMDouble_vtable.get_field_index     =
+            METHOD(VMDouble, get_field_index);
+        _VMDouble_vtable.get_number_of_fields =
+            METHOD(VMDouble, get_number_of_fields);
+        _VMDouble_vtable.get_field           = METHOD(VMDouble, get_field);
+        _VMDouble_vtable.set_field           = METHOD(VMDouble, set_field);
         _VMDouble_vtable.get_embedded_double =
             METHOD(VMDouble, get_embedded_double);
         
-        _VMDouble_vtable.mark_references = 
-            METHOD(VMDouble, mark_references);
+        _VMDouble_vtable.walk_references = 
+            METHOD(VMDouble, walk_references);
+        
+        // SmallFloats are tagged with 10
+        immediate_vtables[SMALL_FLOAT_TAG] = &_VMDouble_vtable;
         
         VMDouble_vtable_inited = true;
     }
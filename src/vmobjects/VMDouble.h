@@ -29,6 +29,9 @@ THE SOFTWARE.
 
 #include <vmobjects/VMObject.h>
 
+#include <stdbool.h>
+#include <string.h>
+
 #pragma mark VTable definition
 
 VTABLE(VMDouble) {
@@ -51,6 +54,72 @@ struct _VMDouble {
     DOUBLE_FORMAT;
 };
 
+#pragma mark SmallFloats
+
+/*
+ * On 64 bit machines, most doubles are not allocated but encoded as
+ * immediates tagged with 10 in the two lowest bits, similar to the
+ * SmallFloats of Spur. The double's bits are rotated left by one to move
+ * the sign to the lowest bit, and the exponent is rebased so that only 9 of
+ * its 11 bits need to be kept. This covers magnitudes between roughly
+ * 1e-77 and 1e77, and zero. All other doubles, as well as all doubles on
+ * 32 bit machines, are boxed VMDoubles.
+ * A SmallFloat reference shares the VTable with the boxed VMDoubles.
+ */
+#define SMALL_FLOAT_TAG ((uintptr_t) 2)
+
+#define IS_SMALL_FLOAT(O) \
+    (((uintptr_t)(O) & IMMEDIATE_TAG_MASK) == SMALL_FLOAT_TAG)
+
+#if INTPTR_MAX == INT64_MAX
+
+#define SMALL_FLOAT_EXPONENT_OFFSET ((uint64_t) 768 << 53)
+#define SMALL_FLOAT_EXPONENT_LIMIT  ((uint64_t) 512 << 53)
+
+static inline bool small_float_encodable(double value, uint64_t* payload) {
+    uint64_t bits; memcpy(&bits, &value, sizeof(bits));
+    uint64_t rotated = (bits << 1) | (bits >> 63);
+    if(rotated <= 1) {
+        // +0.0 and -0.0
+        *payload = rotated;
+        return true;
+    }
+    uint64_t rebased = rotated - SMALL_FLOAT_EXPONENT_OFFSET;
+    // the lowest exponent is left out to keep its payloads for zero
+    if(   rebased >= ((uint64_t) 1 << 53)
+       && rebased <  SMALL_FLOAT_EXPONENT_LIMIT) {
+        *payload = rebased;
+        return true;
+    }
+    return false;
+}
+
+#define SMALL_FLOAT_FOR(PAYLOAD) \
+    ((pVMObject)(uintptr_t)(((PAYLOAD) << 2) | SMALL_FLOAT_TAG))
+
+static inline double small_float_value(void* o) {
+    uint64_t payload = (uint64_t)(uintptr_t)o >> 2;
+    uint64_t rotated = payload <= 1 ? payload
+                                    : payload + SMALL_FLOAT_EXPONENT_OFFSET;
+    uint64_t bits = (rotated >> 1) | (rotated << 63);
+    double value; memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#else
+
+static inline bool small_float_encodable(double value, uint64_t* payload) {
+    return false;
+}
+
+#define SMALL_FLOAT_FOR(PAYLOAD) ((pVMObject)NULL)
+
+static inline double small_float_value(void* o) {
+    return 0.0;
+}
+
+#endif // INTPTR_MAX == INT64_MAX
+
 #pragma mark class methods
 
 pVMDouble VMDouble_new(void);
@@ -135,10 +135,9 @@ void  routine(pVMObject object, pVMFrame frame) {
 }
 
 
-void _VMEvaluationPrimitive_mark_references(void* _self) {
-    pVMEvaluationPrimitive self = (pVMEvaluationPrimitive) _self;
-    gc_mark_object(self->number_of_arguments);
-	SUPER(VMPrimitive, self, mark_references);
+void _VMEvaluationPrimitive_walk_references(void* _self, walk_heap_fn walk) {
+    // the number of arguments is a field
+	SUPER(VMPrimitive, _self, walk_references, walk);
 }
 
 
@@ -158,8 +157,8 @@ VTABLE(VMEvaluationPrimitive)* VMEvaluationPrimitive_vtable(void) {
         _VMEvaluationPrimitive_vtable.free =
             METHOD(VMEvaluationPrimitive, free);
         
-        _VMEvaluationPrimitive_vtable.mark_references = 
-            METHOD(VMEvaluationPrimitive, mark_references);
+        _VMEvaluationPrimitive_vtable.walk_references = 
+            METHOD(VMEvaluationPrimitive, walk_references);
         
         VMEvaluationPrimitive_vtable_inited = true;
     }
@@ -282,12 +282,12 @@ void _VMFrame_print_stack_trace(void* _self) {
     // sending bytecode
     size_t bc_idx = self->bytecode_index;
     if(!SEND(self, is_bootstrap_frame)) 
-        bc_idx -= 2; // length of SEND / SUPER_SEND
+        bc_idx -= 2; // length of SEND / SUPER_SEND and the special sends
     uint8_t bc = SEND(method, get_bytecode, bc_idx);
 
     // current selector, if any
     const char* s_sel = "";
-    if (bc == BC_SEND || bc == BC_SUPER_SEND) {
+    if (bc == BC_SEND || bc == BC_SUPER_SEND || BC_IS_SPECIAL_SEND(bc)) {
         pVMSymbol sel = (pVMSymbol)SEND(method, get_constant, bc_idx);
         s_sel = SEND(sel, get_rawChars);
     }
@@ -312,12 +312,9 @@ size_t _VMFrame__get_offset(void* _self) {
 }
 
 
-void _VMFrame_mark_references(void* _self) {
-    pVMFrame self = (pVMFrame) _self;
-	gc_mark_object(self->previous_frame);
-	gc_mark_object(self->context);
-    gc_mark_object(self->method);
-	SUPER(VMArray, self, mark_references);
+void _VMFrame_walk_references(void* _self, walk_heap_fn walk) {
+    // previous frame, context and method are fields
+	SUPER(VMArray, _self, walk_references, walk);
 }
 
 
@@ -363,8 +360,8 @@ VTABLE(VMFrame)* VMFrame_vtable(void) {
     _VMFrame_vtable.copy_arguments_from = METHOD(VMFrame, copy_arguments_from);
     _VMFrame_vtable._get_offset = METHOD(VMFrame, _get_offset);
     
-    _VMFrame_vtable.mark_references = 
-        METHOD(VMFrame, mark_references);
+    _VMFrame_vtable.walk_references = 
+        METHOD(VMFrame, walk_references);
 
     VMFrame_vtable_inited = true;
 
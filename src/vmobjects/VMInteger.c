@@ -25,9 +25,12 @@ THE SOFTWARE.
   */
 
 #include "VMInteger.h"
+#include "VMClass.h"
 
 #include <memory/gc.h>
 
+#include <vm/Universe.h>
+
 
 //
 //  Class Methods (Starting with VMInteger_) 
@@ -79,8 +82,11 @@ void _VMInteger_init(void* _self, ...) {
 //
 //  Instance Methods (Starting with _VMInteger_) 
 //
+//  All of them are also sent to SmallIntegers, which have no heap storage.
 //
 int64_t _VMInteger_get_embedded_integer(void* _self) {
+    if(IS_SMALL_INTEGER(_self))
+        return SMALL_INTEGER_VALUE(_self);
     pVMInteger self = (pVMInteger)_self;
     return self->embedded_integer;
 }
@@ -93,9 +99,62 @@ void _VMInteger_set_embedded_integer(void* _self, const int64_t embedded) {
 }
 
 
-void _VMInteger_mark_references(void* _self) {
+intptr_t _VMInteger_object_size(void* _self) {
+    if(IS_SMALL_INTEGER(_self))
+        return 0;
+    return SUPER(VMObject, _self, object_size);
+}
+
+
+pVMClass _VMInteger_get_class(void* _self) {
+    if(IS_SMALL_INTEGER(_self))
+        return integer_class;
+    return SUPER(VMObject, _self, get_class);
+}
+
+
+void _VMInteger_set_class(void* _self, pVMClass value) {
+    // SmallIntegers are always instances of the integer class
+    if(!IS_SMALL_INTEGER(_self))
+        SUPER(VMObject, _self, set_class, value);
+}
+
+
+pVMSymbol _VMInteger_get_field_name(void* _self, int64_t index) {
+    return SEND(integer_class, get_instance_field_name, index);
+}
+
+
+int64_t _VMInteger_get_field_index(void* _self, pVMSymbol name) {
+    return SEND(integer_class, lookup_field_index, name);
+}
+
+
+intptr_t _VMInteger_get_number_of_fields(void* _self) {
+    if(IS_SMALL_INTEGER(_self))
+        return 0;
+    return SUPER(VMObject, _self, get_number_of_fields);
+}
+
+
+pVMObject _VMInteger_get_field(void* _self, int64_t index) {
+    if(IS_SMALL_INTEGER(_self))
+        return nil_object;
+    return SUPER(VMObject, _self, get_field, index);
+}
+
+
+void _VMInteger_set_field(void* _self, int64_t index, pVMObject value) {
+    if(!IS_SMALL_INTEGER(_self))
+        SUPER(VMObject, _self, set_field, index, value);
+}
+
+
+void _VMInteger_walk_references(void* _self, walk_heap_fn walk) {
+    if(IS_SMALL_INTEGER(_self))
+        return;
     pVMInteger self = (pVMInteger) _self;
-    SUPER(VMObject, self, mark_references);
+    SUPER(VMObject, self, walk_references, walk);
 }
 
 
@@ -110,11 +169,25 @@ VTABLE(VMInteger)* VMInteger_vtable(void) {
     if(! VMInteger_vtable_inited) {
         *((VTABLE(VMObject)*)&_VMInteger_vtable) = *VMObject_vtable();
         _VMInteger_vtable.init = METHOD(VMInteger, init);
+        _VMInteger_vtable.object_size = METHOD(VMInteger, object_size);
+        _VMInteger_vtable.get_class = METHOD(VMInteger, get_class);
+        _VMInteger_vtable.set_class = METHOD(VMInteger, set_class);
+        _VMInteger_vtable.get_field_name = METHOD(VMInteger, get_field_name);
+        _VMInteger_vtable.get_field_index =
+            METHOD(VMInteger, get_field_index);
+        _VMInteger_vtable.get_number_of_fields =
+            METHOD(VMInteger, get_number_of_fields);
+        _VMInteger_vtable.get_field = METHOD(VMInteger, get_field);
+        _VMInteger_vtable.set_field = METHOD(VMInteger, set_field);
         _VMInteger_vtable.get_embedded_integer =
             METHOD(VMInteger, get_embedded_integer);
         
-        _VMInteger_vtable.mark_references = 
-            METHOD(VMInteger, mark_references);
+        _VMInteger_vtable.walk_references = 
+            METHOD(VMInteger, walk_references);
+
+        // SmallIntegers are tagged with the lowest bit
+        immediate_vtables[SMALL_INTEGER_TAG] = &_VMInteger_vtable;
+        immediate_vtables[SMALL_INTEGER_TAG | 2] = &_VMInteger_vtable;
 
         VMInteger_vtable_inited = true;
     }
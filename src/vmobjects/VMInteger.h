@@ -51,6 +51,30 @@ struct _VMInteger {
     INTEGER_FORMAT;
 };
 
+#pragma mark SmallIntegers
+
+/*
+ * Integers in the range of a tagged pointer are not allocated but encoded
+ * as immediates: the value shifted left by one with the lowest bit set.
+ * This gives 63 bit SmallIntegers on 64 bit machines and 31 bit ones on
+ * 32 bit machines. Only integers outside that range are boxed VMIntegers.
+ * A SmallInteger reference shares the VTable with the boxed VMIntegers.
+ */
+#define SMALL_INTEGER_TAG ((uintptr_t) 1)
+
+#define SMALL_INTEGER_MIN ((int64_t)(INTPTR_MIN >> 1))
+#define SMALL_INTEGER_MAX ((int64_t)(INTPTR_MAX >> 1))
+
+#define IS_SMALL_INTEGER(O) (((uintptr_t)(O) & SMALL_INTEGER_TAG) != 0)
+
+#define FITS_SMALL_INTEGER(V) \
+    ((V) >= SMALL_INTEGER_MIN && (V) <= SMALL_INTEGER_MAX)
+
+#define SMALL_INTEGER_VALUE(O) ((int64_t)((intptr_t)(O) >> 1))
+
+#define SMALL_INTEGER_FOR(V) \
+    ((pVMObject)(((uintptr_t)(intptr_t)(V) << 1) | SMALL_INTEGER_TAG))
+
 #pragma mark class methods
 
 pVMInteger VMInteger_new(void);
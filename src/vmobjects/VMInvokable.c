@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "Signature.h"
 
 #include <vm/Universe.h>
+#include <memory/gc.h>
 
 
 void _VMInvokable_invoke(void* _self, pVMFrame fra) {
@@ -63,6 +64,7 @@ pVMClass _VMInvokable_get_holder(void* _self) {
 
 
 void _VMInvokable_set_holder(void* _self, pVMClass cls) {
+    gc_write_barrier(_self, (pVMObject)cls);
     ((pVMInvokable)_self)->holder = cls;
     if(!TSEND(VMInvokable, (pVMInvokable)_self, is_primitive))
         // if method, change holder subsequently
@@ -70,9 +72,8 @@ void _VMInvokable_set_holder(void* _self, pVMClass cls) {
 }
 
 
-void _VMInvokable_mark_references(void* _self) {
-    pVMInvokable self = (pVMInvokable) _self;
-    SUPER(VMObject, self, mark_references);
+void _VMInvokable_walk_references(void* _self, walk_heap_fn walk) {
+    SUPER(VMObject, _self, walk_references, walk);
 }
 
 //
@@ -92,8 +93,8 @@ VTABLE(VMInvokable)* VMInvokable_vtable(void) {
         _VMInvokable_vtable.get_holder    = METHOD(VMInvokable, get_holder);
         _VMInvokable_vtable.set_holder    = METHOD(VMInvokable, set_holder);
         
-        _VMInvokable_vtable.mark_references = 
-            METHOD(VMInvokable, mark_references);
+        _VMInvokable_vtable.walk_references = 
+            METHOD(VMInvokable, walk_references);
 			
         VMInvokable_vtable_inited = true;
     }
@@ -44,7 +44,7 @@ VTABLE(VMInvokable) {
     pVMClass  (*get_holder)(void*);
     void      (*set_holder)(void*, pVMClass);
     int       (*get_size_of_object)(void*);
-    void      (*mark_references)(void*);
+    void      (*walk_references)(void*, walk_heap_fn);
 };
 
 struct _VMInvokable {
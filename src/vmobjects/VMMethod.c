@@ -44,6 +44,7 @@ THE SOFTWARE.
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 
 //
@@ -72,6 +73,30 @@ pVMMethod VMMethod_new(size_t number_of_bytecodes, size_t number_of_constants,
 }
 
 
+/**
+ * Empty all inline caches of a method, releasing their polymorphic parts
+ */
+void VMMethod_reset_inline_caches(pVMMethod method) {
+    for(size_t i = 0; i < method->bytecodes_length; i++)
+        if(method->inline_caches[i].polymorphic)
+            internal_free(method->inline_caches[i].polymorphic);
+    memset(method->inline_caches, 0,
+           sizeof(inline_cache) * method->bytecodes_length);
+}
+
+
+/**
+ * Release the inline caches of a method
+ */
+void VMMethod_free_inline_caches(pVMMethod method) {
+    if(method->inline_caches) {
+        VMMethod_reset_inline_caches(method);
+        internal_free(method->inline_caches);
+        method->inline_caches = NULL;
+    }
+}
+
+
 pVMMethod VMMethod_assemble(method_generation_context* mgenc) {
     // create a method instance with the given number of bytecodes and literals
     size_t num_literals = SEND(mgenc->literals, size);
@@ -115,6 +140,15 @@ void _VMMethod_init(void* _self, ...) {
     va_end(args);
     
     self->number_of_arguments = Signature_get_number_of_arguments(self->signature);
+    self->inline_caches = NULL;
+    self->inline_cache_epoch = 0;
+}
+
+
+void _VMMethod_free(void* _self) {
+    pVMMethod self = (pVMMethod)_self;
+    VMMethod_free_inline_caches(self);
+    SUPER(VMArray, self, free);
 }
 
 
@@ -218,11 +252,26 @@ void _VMMethod_invoke_method(void* _self, pVMFrame frame) {
 }
 
 
-void _VMMethod_mark_references(void* _self) {
+void _VMMethod_walk_references(void* _self, walk_heap_fn walk) {
     pVMMethod self = (pVMMethod) _self;
-    gc_mark_object(self->signature);
-    gc_mark_object(self->holder); 
-	SUPER(VMArray, self, mark_references);
+    // keep the classes and invokables referenced from inline caches alive, so
+    // that a cached class cannot be replaced by another one at the same address
+    if(self->inline_caches)
+        for(size_t i = 0; i < self->bytecodes_length; i++) {
+            inline_cache* cache = &self->inline_caches[i];
+            cache->receiver_class =
+                (pVMClass)walk((pVMObject)cache->receiver_class);
+            cache->invokable = walk(cache->invokable);
+            if(cache->polymorphic)
+                for(size_t j = 0; j < cache->polymorphic->size; j++) {
+                    polymorphic_cache* pic = cache->polymorphic;
+                    pic->receiver_classes[j] =
+                        (pVMClass)walk((pVMObject)pic->receiver_classes[j]);
+                    pic->invokables[j] = walk(pic->invokables[j]);
+                }
+        }
+    // signature, holder and the constants are fields
+	SUPER(VMArray, self, walk_references, walk);
 }
 
 
@@ -242,6 +291,7 @@ VTABLE(VMMethod)* VMMethod_vtable(void) {
         ASSIGN_TRAIT(VMInvokable, VMMethod);
 
         _VMMethod_vtable.init = METHOD(VMMethod, init);        
+        _VMMethod_vtable.free = METHOD(VMMethod, free);
         _VMMethod_vtable.get_number_of_locals =
             METHOD(VMMethod, get_number_of_locals);
         _VMMethod_vtable.get_maximum_number_of_stack_elements =
@@ -257,8 +307,8 @@ VTABLE(VMMethod)* VMMethod_vtable(void) {
         _VMMethod_vtable.set_bytecode = METHOD(VMMethod, set_bytecode);
         _VMMethod_vtable.invoke_method = METHOD(VMMethod, invoke_method);
         
-        _VMMethod_vtable.mark_references = 
-            METHOD(VMMethod, mark_references);
+        _VMMethod_vtable.walk_references = 
+            METHOD(VMMethod, walk_references);
 
         VMMethod_vtable_inited = true;
     }
@@ -58,6 +58,34 @@ VTABLE(VMMethod) {
 #pragma mark class definition
 
 
+/**
+ * The polymorphic part of an inline cache, allocated once a send site sees a
+ * second receiver class. If it overflows, the send site is megamorphic and
+ * relies on the global lookup cache of VMClass instead.
+ */
+#define POLYMORPHIC_CACHE_SIZE 8
+
+typedef struct _polymorphic_cache {
+    size_t    size;
+    bool      megamorphic;
+    pVMClass  receiver_classes[POLYMORPHIC_CACHE_SIZE];
+    pVMObject invokables[POLYMORPHIC_CACHE_SIZE];
+} polymorphic_cache;
+
+
+/**
+ * Inline cache of a send site: the receiver class first seen at the site and
+ * the invokable the lookup found for it, plus the polymorphic part, if any.
+ * The caches of a method are indexed by the bytecode index of the send, and
+ * are allocated on first use.
+ */
+typedef struct _inline_cache {
+    pVMClass           receiver_class;
+    pVMObject          invokable;
+    polymorphic_cache* polymorphic;
+} inline_cache;
+
+
 #define METHOD_FORMAT \
     ARRAY_FORMAT; \
     pVMSymbol  signature; \
@@ -65,7 +93,9 @@ VTABLE(VMMethod) {
     size_t     number_of_locals; \
     size_t     maximum_number_of_stack_elements; \
     size_t     bytecodes_length; \
-    size_t     number_of_arguments
+    size_t     number_of_arguments; \
+    inline_cache* inline_caches; \
+    uintptr_t  inline_cache_epoch
 
 struct _VMMethod {
     VTABLE(VMMethod)* _vtable;
@@ -81,6 +111,8 @@ pVMMethod VMMethod_new(size_t number_of_constants, size_t number_of_bytecodes,
                        size_t max_number_of_stack_elements,
                        pVMSymbol signature);
 pVMMethod VMMethod_assemble(method_generation_context* mgenc);
+void      VMMethod_reset_inline_caches(pVMMethod method);
+void      VMMethod_free_inline_caches(pVMMethod method);
 
 
 #pragma mark vtable initialization
@@ -110,6 +110,7 @@ pVMObject _VMObject_get_field(void* _self, int64_t index) {
 void _VMObject_set_field(void* _self, int64_t index, pVMObject value) {
     pVMObject self = (pVMObject)_self;
     // set the field with the given index to the given value
+    gc_write_barrier(self, value);
     self->fields[index] = value;
 }
 
@@ -125,6 +126,7 @@ void _VMObject_set_class(void* _self, pVMClass value) {
     pVMObject self = (pVMObject)_self;
     // set class.
     // this is equivalent to setting the Class Index Field
+    gc_write_barrier(self, (pVMObject)value);
     self->class = value;
 }
 
@@ -186,11 +188,11 @@ void VMObject_assert(bool value) {
 }
 
 
-void _VMObject_mark_references(void* _self) {
+void _VMObject_walk_references(void* _self, walk_heap_fn walk) {
     pVMObject self = (pVMObject) _self;
-    gc_mark_object(self->class);
+    self->class = (pVMClass)walk((pVMObject)self->class);
     for(int i = 0;i < SEND(self, get_number_of_fields); i++) {
-        gc_mark_object(SEND(self, get_field, i));
+        self->fields[i] = walk(self->fields[i]);
     }
 }
 
@@ -219,8 +221,8 @@ VTABLE(VMObject)* VMObject_vtable(void) {
         _VMObject_vtable.get_field = METHOD(VMObject, get_field);
         _VMObject_vtable.set_field = METHOD(VMObject, set_field);
 
-        _VMObject_vtable.mark_references = 
-            METHOD(VMObject, mark_references);
+        _VMObject_vtable.walk_references = 
+            METHOD(VMObject, walk_references);
         
         VMObject_vtable_inited = true;
     }
@@ -50,7 +50,7 @@ VTABLE(VMObject) {
     void      (*send)(void*, pVMSymbol, pVMObject*, size_t); \
     pVMObject (*get_field)(void*, int64_t); \
     void      (*set_field)(void*, int64_t, pVMObject); \
-    void      (*mark_references)(void*)
+    void      (*walk_references)(void*, walk_heap_fn)
     
     VMOBJECT_VTABLE_FORMAT;
 };
@@ -136,11 +136,9 @@ void empty_routine(pVMObject self, pVMFrame frame) {
 }
 
 
-void _VMPrimitive_mark_references(void* _self) {
-    pVMPrimitive self = (pVMPrimitive) _self;
-	gc_mark_object(self->signature);
-	gc_mark_object(self->holder);
-	SUPER(VMObject, self, mark_references);
+void _VMPrimitive_walk_references(void* _self, walk_heap_fn walk) {
+    // signature and holder are fields
+	SUPER(VMObject, _self, walk_references, walk);
 }
 
 
@@ -164,8 +162,8 @@ VTABLE(VMPrimitive)* VMPrimitive_vtable(void) {
         _VMPrimitive_vtable.set_routine = METHOD(VMPrimitive, set_routine);
         _VMPrimitive_vtable.free        = METHOD(VMPrimitive, free);
         
-        _VMPrimitive_vtable.mark_references = 
-            METHOD(VMPrimitive, mark_references);
+        _VMPrimitive_vtable.walk_references = 
+            METHOD(VMPrimitive, walk_references);
 
         VMPrimitive_vtable_inited = true;
     }
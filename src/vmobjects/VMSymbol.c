@@ -61,6 +61,9 @@ void _VMSymbol_init(void* _self, ...) {
     size_t len  = va_arg(args, size_t);
 
     SUPER(VMString, _self, init, chars, len);
+    // symbols are hashed by their string, which stays the same when they are
+    // moved
+    ((pVMSymbol)_self)->hash = string_hash(chars, len);
 
     va_end(args);
 }
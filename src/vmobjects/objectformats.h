@@ -62,6 +62,12 @@ typedef void (*routine_fn)(pVMObject, pVMFrame);
 typedef bool (*supports_class_fn)(const char*);
 typedef void (*init_csp_fn)(void);
 
+/**
+ * typedef for functions applied to the references of an object by the
+ * garbage collector; the result replaces the reference.
+ */
+typedef pVMObject (*walk_heap_fn)(pVMObject);
+
 #endif // OBJECTFORMATS_H_
 
 
@@ -106,6 +106,17 @@ static const Test tests[] = {
 
     {"BinaryOperation", "test", (void*) 11, INTEGER},
 
+    {"GarbageCollection", "test", (void*) 5050, INTEGER},
+    {"GarbageCollection", "testOldToYoungReferences", (void*) 5050, INTEGER},
+
+    {"UserDefinedControl", "test",  (void*) 42, INTEGER},
+    {"UserDefinedControl", "test2", (void*) 33, INTEGER},
+    {"UserDefinedControl", "test3", (void*) 42, INTEGER},
+    {"UserDefinedControl", "test4", (void*) 42, INTEGER},
+
+    {"NonLiteralBlocks", "test",  (void*) 1, INTEGER},
+    {"NonLiteralBlocks", "test2", (void*) 3, INTEGER},
+
     {"NumberOfTests", "numberOfTests", (void*) 57, INTEGER},
 
     {NULL}
@@ -166,7 +177,8 @@ static void assert_equals(pVMObject result, Test test) {
 }
 
 void run_test(Test test) {
-    Universe_set_classpath("Smalltalk:TestSuite/BasicInterpreterTests");
+    Universe_set_classpath(
+        "Smalltalk:TestSuite/BasicInterpreterTests:tests/BasicInterpreterTests");
     pVMObject result = Universe_interpret(test.class_name, test.method_name);
 
     assert_equals(result, test);
@@ -176,8 +188,6 @@ void run_test(Test test) {
 
 
 bool run_all_tests() {
-    Parser_init_constants();
-    
     bool has_failures = false;
     for (int i = 0; tests[i].class_name != NULL; i += 1) {
         printf("Test: %s>>#%s\n", tests[i].class_name, tests[i].method_name);
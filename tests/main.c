@@ -1,12 +1,55 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#include <compiler/Parser.h>
+#include <memory/gc.h>
+
 bool run_all_tests(void);
 
+
+typedef struct {
+    const char* description;
+    uint32_t heap_size;     // MB
+    uint32_t max_heap_size; // MB
+    uint32_t gc_time_ratio; // percent
+    uint32_t mark_threads;
+    uint32_t max_pause;     // ms
+    uint32_t nursery_size;  // kB
+} GCSettings;
+
+
+// the basic tests are repeated with each of these settings, the first
+// being the defaults of the VM
+static const GCSettings gc_settings[] = {
+    {"default settings",                   1, 64,  5, 1, 0, 256},
+    {"no nursery (-N0)",                   1, 64,  5, 1, 0,   0},
+    {"a small nursery (-N16)",             1, 64,  5, 1, 0,  16},
+    {"a small heap (-H1 -M2 -R50)",        1,  2, 50, 1, 0, 256},
+    {"parallel marking (-P4)",             1, 64,  5, 4, 0, 256},
+    {"incremental marking (-I1)",          1, 64,  5, 1, 1, 256},
+    {"incremental marking without nursery (-I1 -N0)",
+                                           1, 64,  5, 1, 1,   0},
+    {NULL}
+};
+
+
 int main(int argc, const char * argv[]) {
-    printf("Run Basic Interpreter Tests\n");
+    Parser_init_constants();
+
+    bool has_failures = false;
+    for (int i = 0; gc_settings[i].description != NULL; i += 1) {
+        const GCSettings* settings = &gc_settings[i];
+        printf("Run Basic Interpreter Tests with %s\n", settings->description);
+
+        gc_set_heap_size(settings->heap_size);
+        gc_set_max_heap_size(settings->max_heap_size);
+        gc_set_gc_time_ratio(settings->gc_time_ratio);
+        gc_set_mark_threads(settings->mark_threads);
+        gc_set_max_pause(settings->max_pause);
+        gc_set_nursery_size(settings->nursery_size);
 
-    bool has_failures = run_all_tests();
+        has_failures |= run_all_tests();
+    }
 
     return has_failures ? 1 : 0;
 }